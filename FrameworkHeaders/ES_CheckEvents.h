@@ -9,6 +9,8 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 04:00 mss      each checker now has a priority, a poll period and a
+                         wake flag, see EVENT_CHECK_LIST in ES_Configure.h
  08/05/13 15:19 jec      modifications to suit new portable type definitions
  01/15/12 12:00 jec      new header for local types
  10/16/11 17:17 jec      started coding
@@ -17,12 +19,32 @@
 #ifndef ES_CheckEvents_H
 #define ES_CheckEvents_H
 
+#include "ES_Configure.h"
 #include "ES_Types.h"
 
 typedef bool CheckFunc (void);
 
 typedef CheckFunc (*pCheckFunc);
 
+// the period of a checker that is run on every pass of ES_Run's idle loop
+#define ES_CHECK_EVERY_PASS 0
+// the period of a checker that is only run after ES_CheckerWake
+#define ES_CHECK_ON_WAKE 0xFFFF
+
+// a name for each checker in EVENT_CHECK_LIST, ES_CHECKER_ followed by the
+// name of its function, to pass to ES_CheckerWake
+#define ES_CHECKER_ENUM(Func, Priority, Period) ES_CHECKER_##Func,
+
+typedef enum
+{
+  EVENT_CHECK_LIST(ES_CHECKER_ENUM)
+  ES_NUM_CHECKERS
+}ES_Checker_t;
+
+void ES_InitCheckers(void);
 bool ES_CheckUserEvents(void);
+void ES_CheckerWake(ES_Checker_t Which);
+bool ES_AreCheckersWoken(void);
+uint32_t ES_CheckerTicksToNextDue(void);
 
 #endif  // ES_CheckEvents_H
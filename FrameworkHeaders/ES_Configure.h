@@ -9,6 +9,30 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 11:40 mss     noted that coalescing skips the head of the queue
+ 10/17/26 11:10 mss     Check4Keystroke is woken by the UART receive
+                        interrupt, see ES_TERMINAL_RX_CHECKER
+ 10/17/26 10:50 mss     ES_SCHED_AGING now ages bands and takes turns within
+                        them. The app's policy was changed from strict
+                        priority to ES_SCHED_AGING on 10/16 so that the
+                        hand detect in OptoSensorService can not be starved
+ 10/17/26 08:00 mss     added MOTOR_GOTO & MOTOR_ARRIVED, for position control
+ 10/17/26 05:00 mss     the encoder is decoded in an interrupt, so
+                        CheckEncoderEvents is gone from EVENT_CHECK_LIST
+ 10/17/26 04:00 mss     EVENT_CHECK_LIST now gives each checker a priority
+                        and a poll period
+ 10/17/26 03:00 mss     added ES_TIMER_STATS settings
+ 10/16/26 23:00 mss     added ES_TICKLESS settings
+ 10/16/26 22:00 mss     added ES_TIMER_CALLBACK_LIMIT
+ 10/16/26 20:00 mss     added ES_TIMER_POOL_SIZE
+ 10/16/26 18:00 mss     added ES_NUM_EVENT_TYPES to size the subscriptions
+ 10/16/26 17:00 mss     added ES_TRACE settings
+ 10/16/26 16:00 mss     added ES_PROFILE settings
+ 10/16/26 15:00 mss     raised MAX_NUM_SERVICES to 64
+ 10/16/26 14:00 mss     added the ES_SCHED_ scheduling policy settings
+ 10/16/26 13:05 mss     added ES_COALESCING_EVENTS
+ 10/16/26 12:10 mss     added SERV_n_BATCH
+ 10/16/26 11:20 mss     added SERV_n_QUEUE_KIND, noted the queue size limits
  12/19/16 20:19  jec     removed EVENT_CHECK_HEADER definition. This goes with
                          the V2.3 move to a single wrapper for event checking
                          headers
@@ -26,15 +50,35 @@
 
 /****************************************************************************/
 // The maximum number of services sets an upper bound on the number of
-// services that the framework will handle. Reasonable values are 8 and 16
-// corresponding to an 8-bit(uint8_t) and 16-bit(uint16_t) Ready variable size
-#define MAX_NUM_SERVICES 16
+// services that the framework will handle. Values up to 64 are supported,
+// services beyond 15 need their own SERV_n_ block below, following the
+// pattern of the others
+#define MAX_NUM_SERVICES 64
 
 /****************************************************************************/
 // This macro determines that number of services that are *actually* used in
 // a particular application. It will vary in value from 1 to MAX_NUM_SERVICES
 #define NUM_SERVICES 9
 
+/****************************************************************************/
+// How ES_Run chooses which of the Ready services to run next. One of:
+// ES_SCHED_STRICT    : the highest priority Ready service, always
+// ES_SCHED_BANDED_RR : services are grouped into bands of ES_SCHED_BAND_SIZE
+//                      (0-3, 4-7, ...). The highest band with a Ready
+//                      service runs, taking turns within the band
+// ES_SCHED_AGING     : services are banded as for ES_SCHED_BANDED_RR, and a
+//                      Ready service gains a band of priority for every
+//                      2^ES_SCHED_AGING_SHIFT core timer counts that it
+//                      waits, so that no service can be starved. Services
+//                      of the same band and age take turns
+// This app uses ES_SCHED_AGING so that OptoSensorService (service 0) gets
+// to run while the services above it keep re-posting
+#define ES_SCHED_POLICY ES_SCHED_AGING
+// must be a power of 2, no more than 32
+#define ES_SCHED_BAND_SIZE 4
+// 2^18 counts at 20MHz is 13.1mS per level
+#define ES_SCHED_AGING_SHIFT 18
+
 /****************************************************************************/
 // These are the definitions for Service 0, the lowest priority service.
 // Every Events and Services application must have a Service 0. Further
@@ -46,8 +90,17 @@
 #define SERV_0_INIT InitOptoSensorService//InitAudioService
 // the name of the run function
 #define SERV_0_RUN RunOptoSensorService//RunAudioService
-// How big should this services Queue be?
+// How big should this services Queue be? (1 to 128, the framework rounds
+// this up to a power of 2)
 #define SERV_0_QUEUE_SIZE 5
+// What kind of queue? ES_QUEUE_LOCKED allows posts from anywhere,
+// ES_QUEUE_SPSC is lock-free but must have only one posting context
+// (e.g. a single ISR) besides recalls by the service itself
+#define SERV_0_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events (1 to 255) may it run in one pass of ES_Run? The pass
+// ends early if its queue empties or a higher priority service becomes
+// Ready. Timer ticks are not processed during a pass.
+#define SERV_0_BATCH 1
 
 /****************************************************************************/
 // The following sections are used to define the parameters for each of the
@@ -64,6 +117,10 @@
 #define SERV_1_RUN RunGameService
 // How big should this services Queue be?
 #define SERV_1_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_1_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_1_BATCH 3
 #endif
 
 /****************************************************************************/
@@ -77,6 +134,10 @@
 #define SERV_2_RUN RunAudioService
 // How big should this services Queue be?
 #define SERV_2_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_2_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_2_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -90,6 +151,10 @@
 #define SERV_3_RUN RunServoService
 // How big should this services Queue be?
 #define SERV_3_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_3_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_3_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -103,6 +168,10 @@
 #define SERV_4_RUN RunIRService
 // How big should this services Queue be?
 #define SERV_4_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_4_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_4_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -116,6 +185,10 @@
 #define SERV_5_RUN RunDCMotorService
 // How big should this services Queue be?
 #define SERV_5_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_5_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_5_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -129,6 +202,10 @@
 #define SERV_6_RUN RunThrottleService
 // How big should this services Queue be?
 #define SERV_6_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_6_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_6_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -142,6 +219,10 @@
 #define SERV_7_RUN RunLEDMissileService
 // How big should this services Queue be?
 #define SERV_7_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_7_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_7_BATCH 3
 #endif
 
 /****************************************************************************/
@@ -155,6 +236,10 @@
 #define SERV_8_RUN RunLEDFuelService
 // How big should this services Queue be?
 #define SERV_8_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_8_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_8_BATCH 3
 #endif
 
 /****************************************************************************/
@@ -168,6 +253,10 @@
 #define SERV_9_RUN RunTestHarnessService9
 // How big should this services Queue be?
 #define SERV_9_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_9_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_9_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -181,6 +270,10 @@
 #define SERV_10_RUN RunTestHarnessService10
 // How big should this services Queue be?
 #define SERV_10_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_10_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_10_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -194,6 +287,10 @@
 #define SERV_11_RUN RunTestHarnessService11
 // How big should this services Queue be?
 #define SERV_11_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_11_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_11_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -207,6 +304,10 @@
 #define SERV_12_RUN RunTestHarnessService12
 // How big should this services Queue be?
 #define SERV_12_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_12_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_12_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -220,6 +321,10 @@
 #define SERV_13_RUN RunTestHarnessService13
 // How big should this services Queue be?
 #define SERV_13_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_13_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_13_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -233,6 +338,10 @@
 #define SERV_14_RUN RunTestHarnessService14
 // How big should this services Queue be?
 #define SERV_14_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_14_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_14_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -246,6 +355,10 @@
 #define SERV_15_RUN RunTestHarnessService15
 // How big should this services Queue be?
 #define SERV_15_QUEUE_SIZE 3
+// What kind of queue?
+#define SERV_15_QUEUE_KIND ES_QUEUE_LOCKED
+// How many events may it run in one pass of ES_Run?
+#define SERV_15_BATCH 1
 #endif
 
 /****************************************************************************/
@@ -275,10 +388,12 @@ typedef enum
   IR_READ,
           IR_VALUE,
   /* DC Motor events */
-  MOTOR_CMD,                /* Motor speed cmd */
+  MOTOR_CMD,                /* Motor speed setpoint, deg/S, + is CCW */
   MOTOR_MAX,
   MOTOR_MIN,
           MOTOR_RESET,
+  MOTOR_GOTO,               /* Move to an angle, deg [0,360) */
+  MOTOR_ARRIVED,            /* a MOTOR_GOTO move is done */
   /*Reflective opto sensor events*/
           ROS_READ,
           ROS_RESET,
@@ -292,9 +407,20 @@ typedef enum
           ENCODER_UPDATE,
           SERVO_RESET,
           RESET_ALL,
-          RESET
+          RESET,
+  ES_NUM_EVENT_TYPES        /* not an event, must stay last, see ES_Publish */
 }ES_EventType_t;
 
+/****************************************************************************/
+// These event types carry a reading where only the latest value matters.
+// Posting one to a queue that already holds an event of the same type
+// overwrites the parameter of the queued event instead of taking a new
+// slot. The event at the head of the queue is never overwritten, since
+// ES_Run may already be taking it, so a queue can hold two of a type.
+// Leave undefined (or empty) to turn coalescing off.
+#define ES_COALESCING_EVENTS IR_VALUE, THROTTLE_VALUE, ENCODER_UPDATE, \
+  FUEL_UPDATE
+
 /****************************************************************************/
 // These are the definitions for the Distribution lists. Each definition
 // should be a comma separated list of post functions to indicate which
@@ -326,8 +452,67 @@ typedef enum
 #endif
 
 /****************************************************************************/
-// This is the list of event checking functions
-#define EVENT_CHECK_LIST CheckEncoderEvents, Check4Keystroke
+// Define ES_PROFILE to time every run function and keep queue statistics
+// (see ES_Profile.c). Pressing ES_PROFILE_KEY prints them to the terminal
+// and ES_PROFILE_CLEAR_KEY starts them over. When ES_PROFILE is not
+// defined none of this code is compiled.
+//#define ES_PROFILE
+#define ES_PROFILE_KEY '?'
+#define ES_PROFILE_CLEAR_KEY '!'
+
+/****************************************************************************/
+// Define ES_TRACE to record every post, dequeue, run function entry/exit
+// and timeout with a time stamp (see ES_Trace.c). The records are sent out
+// as binary frames on the terminal UART while ES_Run is idle, so use
+// Tools/es_trace_decode.py to read the terminal output. ES_TRACE_SIZE is
+// the number of records buffered, it must be a power of 2. Each takes 12
+// bytes of RAM.
+//#define ES_TRACE
+#define ES_TRACE_SIZE 128
+
+/****************************************************************************/
+// Define ES_TIMER_STATS to keep a histogram, for each timer, of how long
+// its ES_TIMEOUTs wait in a queue before they are run, and to count the
+// ticks that had to be caught up (see ES_TimerStats.c). Pressing
+// ES_TIMER_STATS_KEY prints them to the terminal and
+// ES_TIMER_STATS_CLEAR_KEY starts them over.
+//#define ES_TIMER_STATS
+#define ES_TIMER_STATS_KEY '#'
+#define ES_TIMER_STATS_CLEAR_KEY '$'
+
+/****************************************************************************/
+// Define ES_TICKLESS to have ES_Run stop the tick and WAIT whenever the
+// queues are empty, the event checkers found nothing and the terminal has
+// nothing left to send. The CPU sleeps until the next timer expires, any
+// interrupt wakes it or ES_TICKLESS_MAX_TICKS ticks pass, and the ticks it
+// slept through are then credited to the timers all at once.
+// The CPU also wakes in time for the next checker with a poll period, but
+// an ES_CHECK_EVERY_PASS checker only runs when something else woke the
+// CPU, at least every ES_TICKLESS_MAX_TICKS ticks.
+//#define ES_TICKLESS
+#define ES_TICKLESS_MAX_TICKS 100
+
+/****************************************************************************/
+// This is the list of event checking functions. Each entry is
+// M(Function, Priority, Period):
+//  Priority: the checkers that are due are run in order of priority, 0
+//    first, all of them on each pass even if one finds an event.
+//  Period: the ticks between runs, ES_CHECK_EVERY_PASS to run on each pass
+//    of ES_Run's idle loop (as fast as possible), or ES_CHECK_ON_WAKE to run
+//    only after an ISR calls ES_CheckerWake(ES_CHECKER_<Function>).
+// Any checker runs on the next pass after an ES_CheckerWake, whatever its
+// period. There can be at most 32 checkers.
+// Check4Keystroke is only run when the UART receive interrupt wakes it,
+// see ES_TERMINAL_RX_CHECKER, so it costs nothing until a key arrives and
+// does not keep ES_TICKLESS from sleeping.
+#define EVENT_CHECK_LIST(M) \
+  M(Check4Keystroke, 0, ES_CHECK_ON_WAKE)
+
+// The checker that the UART receive interrupt wakes with ES_CheckerWake
+// when a byte arrives (on the host port, a look at stdin on each tick).
+// Comment it out to leave the receive interrupt off, and then give
+// Check4Keystroke a poll period in EVENT_CHECK_LIST instead.
+#define ES_TERMINAL_RX_CHECKER ES_CHECKER_Check4Keystroke
 
 /****************************************************************************/
 // These are the definitions for the post functions to be executed when the
@@ -353,6 +538,17 @@ typedef enum
 #define TIMER14_RESP_FUNC PostGameService
 #define TIMER15_RESP_FUNC PostServoService
 
+// The number of timers in the pool that services allocate at run time with
+// ES_Timer_Alloc, in addition to the 16 above. The pool timers are bound to
+// their service when allocated, so they need no _RESP_FUNC or number here.
+// The 16 numbered timers plus the pool can not be more than 64.
+#define ES_TIMER_POOL_SIZE 8
+
+// The longest that a timer callback (see ES_Timer_SetCallback) may run, in
+// core timer counts of 50nS. A callback that takes longer is dropped and
+// its timer posts ES_TIMEOUT instead. 2000 is 100uS, 1/10 of a 1mS tick.
+#define ES_TIMER_CALLBACK_LIMIT 2000
+
 /****************************************************************************/
 // Give the timer numbers symbolic names to make it easier to move them
 // to different timers if the need arises. Keep these definitions close to the
@@ -8,6 +8,12 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 10:50 mss      ES_SCHED_AGING is now banded, with turns in a band
+ 10/17/26 10:20 mss      ES_QueueKind_t moved here from ES_Queue.h
+ 10/16/26 18:00 mss      added ES_Subscribe, ES_Unsubscribe & ES_Publish
+ 10/16/26 16:00 mss      added ES_GetQueueSize prototype
+ 10/16/26 14:00 mss      added the scheduling policies & wait time functions
+ 10/16/26 10:05 mss      added ES_PostToServiceFromISR prototype
  11/02/13 17:06 jec      added ES_PostToServiceLIFO prototype
  08/05/13 15:00 jec      added #include for ES_Port.h to get portability stuff
  10/17/06 07:41 jec      started coding
@@ -40,10 +46,31 @@ typedef enum
   FailedOther
 }ES_Return_t;
 
+// the kinds of service queue, select one for each service with
+// SERV_n_QUEUE_KIND in ES_Configure.h
+typedef enum
+{
+  ES_QUEUE_LOCKED = 0,  // any number of posters, uses critical regions
+  ES_QUEUE_SPSC         // lock-free, one ISR posting & ES_Run consuming
+}ES_QueueKind_t;
+
+// the policies that ES_Run can use to pick among the Ready services,
+// select one with ES_SCHED_POLICY in ES_Configure.h
+#define ES_SCHED_STRICT 0     // highest numbered Ready service runs first
+#define ES_SCHED_BANDED_RR 1  // round-robin within the highest Ready band
+#define ES_SCHED_AGING 2      // as BANDED_RR, but a band rises as it waits
+
 ES_Return_t ES_Initialize(TimerRate_t NewRate);
 ES_Return_t ES_Run(void);
 bool ES_PostAll(ES_Event_t ThisEvent);
 bool ES_PostToService(uint8_t WhichService, ES_Event_t ThisEvent);
 bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent);
+bool ES_PostToServiceFromISR(uint8_t WhichService, ES_Event_t TheEvent);
+bool ES_Subscribe(uint8_t WhichService, ES_EventType_t EventType);
+bool ES_Unsubscribe(uint8_t WhichService, ES_EventType_t EventType);
+bool ES_Publish(ES_Event_t ThisEvent);
+uint32_t ES_GetMaxWait(uint8_t WhichService);
+void ES_ClearMaxWaits(void);
+uint8_t ES_GetQueueSize(uint8_t WhichService);
 
 #endif   // ES_Framework_H
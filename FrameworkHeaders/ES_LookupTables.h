@@ -17,6 +17,8 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/16/26 15:00 mss      added ES_GetMSBitSet32 & ES_MSBitOfNonZero, which use
+                         the count leading zeros instruction when available
  10/20/13 21:19 jec      got rid of BitNum2ClrMask and replaced with #define
                          replaced Byte2MSBNum with function ES_GetMSBSet
                          replaced Byte2MSBNum array with Nybble2MSBNum
@@ -61,3 +63,28 @@ extern uint8_t const Nybble2MSBitNum[15];
    J. Edward Carryer, 10/20/13, 17:03
 ****************************************************************************/
 uint8_t ES_GetMSBitSet(uint16_t Val2Check);
+
+/****************************************************************************
+ Function
+   ES_GetMSBitSet32
+ Parameters
+   uint32_t  Val2Check The number to find the MSB in
+ Returns
+   bit number of the MSB that is set in Val2Check, 128 if Val2Check = 0
+ Description
+   32 bit version of ES_GetMSBitSet
+ Author
+   M. Saboo, 10/16/26, 15:00
+****************************************************************************/
+uint8_t ES_GetMSBitSet32(uint32_t Val2Check);
+
+/*
+  Fast form for the scheduler, for a value that is known not to be 0.
+  GCC based compilers (XC32 included) turn __builtin_clz into the MIPS32 clz
+  instruction, anything else falls back to the nybble lookup.
+*/
+#ifdef __GNUC__
+#define ES_MSBitOfNonZero(Val) ((uint8_t)(31 - __builtin_clz(Val)))
+#else
+#define ES_MSBitOfNonZero(Val) ES_GetMSBitSet32(Val)
+#endif
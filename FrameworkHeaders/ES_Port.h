@@ -9,6 +9,11 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 11:20 mss     added _HW_GetLastTickCount
+ 10/17/26 01:00 mss     added ES_CORE_COUNTS_PER_US
+ 10/16/26 23:00 mss     added _HW_IdleWait for ES_TICKLESS
+ 10/16/26 09:12 mss     added the ES_HOST_PORT configuration for running the
+                        framework on a Linux host (see ES_Port_Host.c)
  10/26/17 18:39 jec     moves definition of ALL_BITS to here
  10/14/15 21:50 jec     added prototype for ES_Timer_GetTime
  01/18/15 13:24 jec     clean up and adapt to use TI driver lib functions
@@ -22,8 +27,12 @@
 #ifndef ES_PORT_H
 #define ES_PORT_H
 
+// The Linux host port is selected by building with -DES_HOST_PORT. In that
+// case ES_Port_Host.c & terminal_Host.c replace ES_Port.c & terminal.c
 // pull in the hardware header files that we need
+#ifndef ES_HOST_PORT
 #include <xc.h>
+#endif
 
 #include <stdio.h>
 #include <stdint.h>
@@ -67,7 +76,11 @@ extern  uint8_t _INTCON_temp;
 // this definition commented. if you ever get posting from within a int working
 // then uncomment it.
 // For the PIC32, we *can* post from interrupts
+// On the host port the tick is polled from ES_Run, so nothing runs
+// asynchronously and the critical regions compile to nothing
+#ifndef ES_HOST_PORT
 #define POST_FROM_INTS
+#endif
 
 // in the MIPS architecture, interrupts are not disabled on entry to an ISR
 // the interrupt controller simply prevents interrupts from lower or the
@@ -98,6 +111,9 @@ typedef enum
   ES_Timer_RATE_5mS  = 100000,       /* 5ms timer tick */
 }TimerRate_t;
 
+// the core timer (CP0 Count) rate, it also sets the units of ES_GetTime64
+#define ES_CORE_COUNTS_PER_US 20
+
 #if 0 // Moved to terminal.h
 // map the generic functions for testing the serial port to actual functions
 // for this platform. If the C compiler does not provide functions to test
@@ -112,6 +128,13 @@ void putch(char data);
 bool kbhit(void);                // is a charcter ready on the EUSART?
 #endif
 
+#ifdef ES_HOST_PORT
+// The host port keeps a simulated 20MHz core timer count so that code
+// written against the CP0 Count register measures the same units on Linux
+uint32_t _HW_GetCoreCount(void);
+#define _CP0_GET_COUNT() _HW_GetCoreCount()
+#endif
+
 // prototypes for the hardware specific routines
 void _HW_PIC32Init(void);
 void _HW_Timer_Init(const TimerRate_t Rate);
@@ -119,6 +142,8 @@ bool _HW_Process_Pending_Ints(void);
 uint16_t _HW_GetTickCount(void);
 void _HW_ConsoleInit(void);
 void _HW_SysTickIntHandler(void);
+void _HW_IdleWait(uint32_t MaxTicks);
+uint32_t _HW_GetLastTickCount(void);
 
 // and the one Framework function that we define here
 uint16_t ES_Timer_GetTime(void);
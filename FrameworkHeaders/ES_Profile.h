@@ -0,0 +1,51 @@
+/****************************************************************************
+ Module
+     ES_Profile.h
+ Description
+     header file for the optional run time profiling of the services
+ Notes
+     Everything here compiles to nothing unless ES_PROFILE is defined in
+     ES_Configure.h. The hooks are macros so that ES_Framework.c does not
+     need any #ifdefs of its own.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/16/26 16:00 mss      started coding
+*****************************************************************************/
+#ifndef ES_Profile_H
+#define ES_Profile_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Port.h"
+
+#ifdef ES_PROFILE
+
+// number of log2 buckets in each run time histogram. Bucket b counts runs
+// of 2^b to 2^(b+1) - 1 core timer counts, the last one everything longer
+#define ES_PROFILE_BUCKETS 24
+
+// hooks used by ES_Framework.c
+#define ES_PROFILE_RUN_START() uint32_t ProfileStart = _CP0_GET_COUNT()
+#define ES_PROFILE_RUN_END(Which) \
+  ES_Profile_NoteRun((Which), _CP0_GET_COUNT() - ProfileStart)
+#define ES_PROFILE_POST(Which, NumEntries) \
+  ES_Profile_NotePost((Which), (NumEntries))
+#define ES_PROFILE_POST_FAILED(Which) ES_Profile_NotePostFailed(Which)
+
+void ES_Profile_NoteRun(uint8_t WhichService, uint32_t Counts);
+void ES_Profile_NotePost(uint8_t WhichService, uint8_t NumEntries);
+void ES_Profile_NotePostFailed(uint8_t WhichService);
+void ES_Profile_Report(void);
+void ES_Profile_Clear(void);
+
+#else
+
+#define ES_PROFILE_RUN_START()
+#define ES_PROFILE_RUN_END(Which)
+#define ES_PROFILE_POST(Which, NumEntries)
+#define ES_PROFILE_POST_FAILED(Which)
+
+#endif /* ES_PROFILE */
+
+#endif /* ES_Profile_H */
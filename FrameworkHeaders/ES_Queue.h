@@ -9,6 +9,9 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 10:20 mss      ES_QueueKind_t moved to ES_Framework.h, removed
+                         ES_InitQueueSPSC & ES_EnQueueFromISR
+ 10/16/26 10:05 mss      added ES_QueueKind_t, ES_InitQueueSPSC & ES_EnQueueFromISR
  08/05/13 15:19 jec      modifications to suit new portable type definitions
  01/15/12 09:36 jec      converted to use new types from ES_Types.h
  10/17/11 07:49 jec      new header to match the rest of the framework
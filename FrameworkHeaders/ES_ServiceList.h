@@ -0,0 +1,364 @@
+/****************************************************************************
+ Module
+     ES_ServiceList.h
+ Description
+     Generates the per-service tables of the framework from the SERV_n_
+     definitions in ES_Configure.h
+ Notes
+     ES_FOR_EACH_SERVICE(M) expands to M(0) M(1) ... M(NUM_SERVICES - 1),
+     so that each table in ES_Framework.c is written once rather than once
+     per service. A #if can not be used inside a macro, so the test for
+     NUM_SERVICES is made once per service here instead.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/16/26 15:00 mss      started coding
+*****************************************************************************/
+#ifndef ES_ServiceList_H
+#define ES_ServiceList_H
+
+#include "ES_Configure.h"
+
+#if (NUM_SERVICES < 1) || (NUM_SERVICES > MAX_NUM_SERVICES)
+#error "NUM_SERVICES must be from 1 to MAX_NUM_SERVICES"
+#endif
+#if MAX_NUM_SERVICES > 64
+#error "ES_ServiceList.h only goes up to 64 services"
+#endif
+
+#define ES_SERVICE_0(M) M(0)
+#if NUM_SERVICES > 1
+#define ES_SERVICE_1(M) M(1)
+#else
+#define ES_SERVICE_1(M)
+#endif
+#if NUM_SERVICES > 2
+#define ES_SERVICE_2(M) M(2)
+#else
+#define ES_SERVICE_2(M)
+#endif
+#if NUM_SERVICES > 3
+#define ES_SERVICE_3(M) M(3)
+#else
+#define ES_SERVICE_3(M)
+#endif
+#if NUM_SERVICES > 4
+#define ES_SERVICE_4(M) M(4)
+#else
+#define ES_SERVICE_4(M)
+#endif
+#if NUM_SERVICES > 5
+#define ES_SERVICE_5(M) M(5)
+#else
+#define ES_SERVICE_5(M)
+#endif
+#if NUM_SERVICES > 6
+#define ES_SERVICE_6(M) M(6)
+#else
+#define ES_SERVICE_6(M)
+#endif
+#if NUM_SERVICES > 7
+#define ES_SERVICE_7(M) M(7)
+#else
+#define ES_SERVICE_7(M)
+#endif
+#if NUM_SERVICES > 8
+#define ES_SERVICE_8(M) M(8)
+#else
+#define ES_SERVICE_8(M)
+#endif
+#if NUM_SERVICES > 9
+#define ES_SERVICE_9(M) M(9)
+#else
+#define ES_SERVICE_9(M)
+#endif
+#if NUM_SERVICES > 10
+#define ES_SERVICE_10(M) M(10)
+#else
+#define ES_SERVICE_10(M)
+#endif
+#if NUM_SERVICES > 11
+#define ES_SERVICE_11(M) M(11)
+#else
+#define ES_SERVICE_11(M)
+#endif
+#if NUM_SERVICES > 12
+#define ES_SERVICE_12(M) M(12)
+#else
+#define ES_SERVICE_12(M)
+#endif
+#if NUM_SERVICES > 13
+#define ES_SERVICE_13(M) M(13)
+#else
+#define ES_SERVICE_13(M)
+#endif
+#if NUM_SERVICES > 14
+#define ES_SERVICE_14(M) M(14)
+#else
+#define ES_SERVICE_14(M)
+#endif
+#if NUM_SERVICES > 15
+#define ES_SERVICE_15(M) M(15)
+#else
+#define ES_SERVICE_15(M)
+#endif
+#if NUM_SERVICES > 16
+#define ES_SERVICE_16(M) M(16)
+#else
+#define ES_SERVICE_16(M)
+#endif
+#if NUM_SERVICES > 17
+#define ES_SERVICE_17(M) M(17)
+#else
+#define ES_SERVICE_17(M)
+#endif
+#if NUM_SERVICES > 18
+#define ES_SERVICE_18(M) M(18)
+#else
+#define ES_SERVICE_18(M)
+#endif
+#if NUM_SERVICES > 19
+#define ES_SERVICE_19(M) M(19)
+#else
+#define ES_SERVICE_19(M)
+#endif
+#if NUM_SERVICES > 20
+#define ES_SERVICE_20(M) M(20)
+#else
+#define ES_SERVICE_20(M)
+#endif
+#if NUM_SERVICES > 21
+#define ES_SERVICE_21(M) M(21)
+#else
+#define ES_SERVICE_21(M)
+#endif
+#if NUM_SERVICES > 22
+#define ES_SERVICE_22(M) M(22)
+#else
+#define ES_SERVICE_22(M)
+#endif
+#if NUM_SERVICES > 23
+#define ES_SERVICE_23(M) M(23)
+#else
+#define ES_SERVICE_23(M)
+#endif
+#if NUM_SERVICES > 24
+#define ES_SERVICE_24(M) M(24)
+#else
+#define ES_SERVICE_24(M)
+#endif
+#if NUM_SERVICES > 25
+#define ES_SERVICE_25(M) M(25)
+#else
+#define ES_SERVICE_25(M)
+#endif
+#if NUM_SERVICES > 26
+#define ES_SERVICE_26(M) M(26)
+#else
+#define ES_SERVICE_26(M)
+#endif
+#if NUM_SERVICES > 27
+#define ES_SERVICE_27(M) M(27)
+#else
+#define ES_SERVICE_27(M)
+#endif
+#if NUM_SERVICES > 28
+#define ES_SERVICE_28(M) M(28)
+#else
+#define ES_SERVICE_28(M)
+#endif
+#if NUM_SERVICES > 29
+#define ES_SERVICE_29(M) M(29)
+#else
+#define ES_SERVICE_29(M)
+#endif
+#if NUM_SERVICES > 30
+#define ES_SERVICE_30(M) M(30)
+#else
+#define ES_SERVICE_30(M)
+#endif
+#if NUM_SERVICES > 31
+#define ES_SERVICE_31(M) M(31)
+#else
+#define ES_SERVICE_31(M)
+#endif
+#if NUM_SERVICES > 32
+#define ES_SERVICE_32(M) M(32)
+#else
+#define ES_SERVICE_32(M)
+#endif
+#if NUM_SERVICES > 33
+#define ES_SERVICE_33(M) M(33)
+#else
+#define ES_SERVICE_33(M)
+#endif
+#if NUM_SERVICES > 34
+#define ES_SERVICE_34(M) M(34)
+#else
+#define ES_SERVICE_34(M)
+#endif
+#if NUM_SERVICES > 35
+#define ES_SERVICE_35(M) M(35)
+#else
+#define ES_SERVICE_35(M)
+#endif
+#if NUM_SERVICES > 36
+#define ES_SERVICE_36(M) M(36)
+#else
+#define ES_SERVICE_36(M)
+#endif
+#if NUM_SERVICES > 37
+#define ES_SERVICE_37(M) M(37)
+#else
+#define ES_SERVICE_37(M)
+#endif
+#if NUM_SERVICES > 38
+#define ES_SERVICE_38(M) M(38)
+#else
+#define ES_SERVICE_38(M)
+#endif
+#if NUM_SERVICES > 39
+#define ES_SERVICE_39(M) M(39)
+#else
+#define ES_SERVICE_39(M)
+#endif
+#if NUM_SERVICES > 40
+#define ES_SERVICE_40(M) M(40)
+#else
+#define ES_SERVICE_40(M)
+#endif
+#if NUM_SERVICES > 41
+#define ES_SERVICE_41(M) M(41)
+#else
+#define ES_SERVICE_41(M)
+#endif
+#if NUM_SERVICES > 42
+#define ES_SERVICE_42(M) M(42)
+#else
+#define ES_SERVICE_42(M)
+#endif
+#if NUM_SERVICES > 43
+#define ES_SERVICE_43(M) M(43)
+#else
+#define ES_SERVICE_43(M)
+#endif
+#if NUM_SERVICES > 44
+#define ES_SERVICE_44(M) M(44)
+#else
+#define ES_SERVICE_44(M)
+#endif
+#if NUM_SERVICES > 45
+#define ES_SERVICE_45(M) M(45)
+#else
+#define ES_SERVICE_45(M)
+#endif
+#if NUM_SERVICES > 46
+#define ES_SERVICE_46(M) M(46)
+#else
+#define ES_SERVICE_46(M)
+#endif
+#if NUM_SERVICES > 47
+#define ES_SERVICE_47(M) M(47)
+#else
+#define ES_SERVICE_47(M)
+#endif
+#if NUM_SERVICES > 48
+#define ES_SERVICE_48(M) M(48)
+#else
+#define ES_SERVICE_48(M)
+#endif
+#if NUM_SERVICES > 49
+#define ES_SERVICE_49(M) M(49)
+#else
+#define ES_SERVICE_49(M)
+#endif
+#if NUM_SERVICES > 50
+#define ES_SERVICE_50(M) M(50)
+#else
+#define ES_SERVICE_50(M)
+#endif
+#if NUM_SERVICES > 51
+#define ES_SERVICE_51(M) M(51)
+#else
+#define ES_SERVICE_51(M)
+#endif
+#if NUM_SERVICES > 52
+#define ES_SERVICE_52(M) M(52)
+#else
+#define ES_SERVICE_52(M)
+#endif
+#if NUM_SERVICES > 53
+#define ES_SERVICE_53(M) M(53)
+#else
+#define ES_SERVICE_53(M)
+#endif
+#if NUM_SERVICES > 54
+#define ES_SERVICE_54(M) M(54)
+#else
+#define ES_SERVICE_54(M)
+#endif
+#if NUM_SERVICES > 55
+#define ES_SERVICE_55(M) M(55)
+#else
+#define ES_SERVICE_55(M)
+#endif
+#if NUM_SERVICES > 56
+#define ES_SERVICE_56(M) M(56)
+#else
+#define ES_SERVICE_56(M)
+#endif
+#if NUM_SERVICES > 57
+#define ES_SERVICE_57(M) M(57)
+#else
+#define ES_SERVICE_57(M)
+#endif
+#if NUM_SERVICES > 58
+#define ES_SERVICE_58(M) M(58)
+#else
+#define ES_SERVICE_58(M)
+#endif
+#if NUM_SERVICES > 59
+#define ES_SERVICE_59(M) M(59)
+#else
+#define ES_SERVICE_59(M)
+#endif
+#if NUM_SERVICES > 60
+#define ES_SERVICE_60(M) M(60)
+#else
+#define ES_SERVICE_60(M)
+#endif
+#if NUM_SERVICES > 61
+#define ES_SERVICE_61(M) M(61)
+#else
+#define ES_SERVICE_61(M)
+#endif
+#if NUM_SERVICES > 62
+#define ES_SERVICE_62(M) M(62)
+#else
+#define ES_SERVICE_62(M)
+#endif
+#if NUM_SERVICES > 63
+#define ES_SERVICE_63(M) M(63)
+#else
+#define ES_SERVICE_63(M)
+#endif
+
+#define ES_FOR_EACH_SERVICE(M) \
+  ES_SERVICE_0(M) ES_SERVICE_1(M) ES_SERVICE_2(M) ES_SERVICE_3(M) \
+  ES_SERVICE_4(M) ES_SERVICE_5(M) ES_SERVICE_6(M) ES_SERVICE_7(M) \
+  ES_SERVICE_8(M) ES_SERVICE_9(M) ES_SERVICE_10(M) ES_SERVICE_11(M) \
+  ES_SERVICE_12(M) ES_SERVICE_13(M) ES_SERVICE_14(M) ES_SERVICE_15(M) \
+  ES_SERVICE_16(M) ES_SERVICE_17(M) ES_SERVICE_18(M) ES_SERVICE_19(M) \
+  ES_SERVICE_20(M) ES_SERVICE_21(M) ES_SERVICE_22(M) ES_SERVICE_23(M) \
+  ES_SERVICE_24(M) ES_SERVICE_25(M) ES_SERVICE_26(M) ES_SERVICE_27(M) \
+  ES_SERVICE_28(M) ES_SERVICE_29(M) ES_SERVICE_30(M) ES_SERVICE_31(M) \
+  ES_SERVICE_32(M) ES_SERVICE_33(M) ES_SERVICE_34(M) ES_SERVICE_35(M) \
+  ES_SERVICE_36(M) ES_SERVICE_37(M) ES_SERVICE_38(M) ES_SERVICE_39(M) \
+  ES_SERVICE_40(M) ES_SERVICE_41(M) ES_SERVICE_42(M) ES_SERVICE_43(M) \
+  ES_SERVICE_44(M) ES_SERVICE_45(M) ES_SERVICE_46(M) ES_SERVICE_47(M) \
+  ES_SERVICE_48(M) ES_SERVICE_49(M) ES_SERVICE_50(M) ES_SERVICE_51(M) \
+  ES_SERVICE_52(M) ES_SERVICE_53(M) ES_SERVICE_54(M) ES_SERVICE_55(M) \
+  ES_SERVICE_56(M) ES_SERVICE_57(M) ES_SERVICE_58(M) ES_SERVICE_59(M) \
+  ES_SERVICE_60(M) ES_SERVICE_61(M) ES_SERVICE_62(M) ES_SERVICE_63(M)
+
+#endif /* ES_ServiceList_H */
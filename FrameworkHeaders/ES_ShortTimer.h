@@ -0,0 +1,46 @@
+/****************************************************************************
+ Module
+     ES_ShortTimer.h
+ Description
+     header file for the short (microsecond) one-shot timers
+ Notes
+     See ES_ShortTimer.c for the PIC32 implementation and its latency, and
+     ES_ShortTimer_Host.c for the host port stand-in.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 02:00 mss      first version, for the PIC32 port of ES_ShortTimer.c
+*****************************************************************************/
+#ifndef ES_ShortTimer_H
+#define ES_ShortTimer_H
+
+#include "ES_Types.h"
+
+// the short timer channels, each posts ES_SHORT_TIMEOUT with the channel
+// as the EventParam
+typedef enum
+{
+  ES_SHORT_TIMER_A = 0,     // Timer4 on the PIC32
+  ES_SHORT_TIMER_B,         // Timer5 on the PIC32
+  ES_NUM_SHORT_TIMERS
+}ES_ShortTimer_t;
+
+// pass as the service for a channel that will not be used
+#define SHORT_TIMER_UNUSED 0xFF
+
+// timeouts shorter than this, in uS, are posted from ES_ShortTimerStart
+// rather than waiting for an interrupt that would come later anyway
+#define ES_SHORT_TIMER_MIN_US 2
+
+void ES_ShortTimerInit(uint8_t TimeAPrio, uint8_t TimeBPrio);
+void ES_ShortTimerStart(ES_ShortTimer_t Which, uint16_t TimeoutValue);
+void ES_ShortTimerStop(ES_ShortTimer_t Which);
+bool ES_ShortTimerIsRunning(ES_ShortTimer_t Which);
+
+#ifdef ES_HOST_PORT
+// called by _HW_Process_Pending_Ints on the host port in place of the
+// timer interrupts
+void ES_ShortTimer_HostPoll(void);
+#endif
+
+#endif /* ES_ShortTimer_H */
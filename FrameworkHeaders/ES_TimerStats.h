@@ -0,0 +1,57 @@
+/****************************************************************************
+ Module
+     ES_TimerStats.h
+ Description
+     header file for the optional lateness statistics of the framework
+     timers
+ Notes
+     Everything here compiles to nothing unless ES_TIMER_STATS is defined in
+     ES_Configure.h. The hooks are macros so that ES_Timers.c and the ports
+     do not need any #ifdefs of their own.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 11:20 mss      ES_TIMER_STATS_EXPIRED takes the count the timer
+                         was due at
+ 10/17/26 11:00 mss      added ES_TIMER_STATS_SLEPT
+ 10/17/26 03:00 mss      started coding
+*****************************************************************************/
+#ifndef ES_TimerStats_H
+#define ES_TimerStats_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+
+#ifdef ES_TIMER_STATS
+
+// number of log2 buckets in each lateness histogram. Bucket b counts
+// lateness under 64 * 2^b core timer counts (3.2uS * 2^b), the last one
+// everything longer
+#define ES_TIMER_STATS_BUCKETS 16
+
+// hooks used by ES_Timers.c and the ports
+#define ES_TIMER_STATS_EXPIRED(Num, DueAt) ES_TimerStats_NoteExpiry(Num, DueAt)
+#define ES_TIMER_STATS_DISPATCHED(Num) ES_TimerStats_NoteDispatch(Num)
+#define ES_TIMER_STATS_ADVANCE(Ticks) ES_TimerStats_NoteAdvance(Ticks)
+#define ES_TIMER_STATS_CATCH_UP(Ticks) ES_TimerStats_NoteCatchUp(Ticks)
+#define ES_TIMER_STATS_SLEPT(Ticks) ES_TimerStats_NoteSlept(Ticks)
+
+void ES_TimerStats_NoteExpiry(uint8_t Num, uint32_t DueAt);
+void ES_TimerStats_NoteDispatch(uint16_t Num);
+void ES_TimerStats_NoteAdvance(uint32_t Ticks);
+void ES_TimerStats_NoteCatchUp(uint32_t Ticks);
+void ES_TimerStats_NoteSlept(uint32_t Ticks);
+void ES_TimerStats_Report(void);
+void ES_TimerStats_Clear(void);
+
+#else
+
+#define ES_TIMER_STATS_EXPIRED(Num, DueAt)
+#define ES_TIMER_STATS_DISPATCHED(Num)
+#define ES_TIMER_STATS_ADVANCE(Ticks)
+#define ES_TIMER_STATS_CATCH_UP(Ticks)
+#define ES_TIMER_STATS_SLEPT(Ticks)
+
+#endif /* ES_TIMER_STATS */
+
+#endif /* ES_TimerStats_H */
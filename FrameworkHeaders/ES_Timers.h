@@ -14,6 +14,13 @@
  History
  When           Who	What/Why
  -------------- ---	--------
+ 10/17/26 11:00 mss  moved the number of timers here from ES_Timers.c
+ 10/17/26 01:00 mss  added the 64 bit clock, ES_GetTime64 and ES_GetTime_us
+ 10/17/26 00:00 mss  added ES_Timer_Advance
+ 10/16/26 23:00 mss  added ES_Timer_TicksToNextExpiry
+ 10/16/26 22:00 mss  added the callback timer functions
+ 10/16/26 21:00 mss  added the periodic timer functions
+ 10/16/26 20:00 mss  timers take 32 bit times, added the timer handle pool
  10/13/15 20:48 jec  removed prototype for IsTimerActive, I had removed the code
                      a couple of years ago
  08/13/13 12:03 jec  added prototype for ES_Timer_Tick_Resp as part of
@@ -31,6 +38,7 @@
 #ifndef ES_Timers_H
 #define ES_Timers_H
 
+#include "ES_Configure.h"
 #include "ES_Port.h"
 #include "ES_Types.h"
 
@@ -42,13 +50,44 @@ typedef enum
   ES_Timer_NOT_ACTIVE = 0
 }ES_TimerReturn_t;
 
+// the 16 numbered timers, then the pool. Every timer number and pool handle
+// is below ES_NUM_TIMERS
+#define ES_NUM_NUMBERED_TIMERS 16
+#define ES_NUM_TIMERS (ES_NUM_NUMBERED_TIMERS + ES_TIMER_POOL_SIZE)
+
+// a timer allocated from the pool with ES_Timer_Alloc
+typedef uint8_t ES_TimerHandle_t;
+#define ES_TIMER_NO_HANDLE 0xFF
+
+// convert a difference of two _CP0_GET_COUNT() readings (up to 214 seconds)
+// to uS or mS, 32 bit divides by a constant
+#define ES_COUNTS_TO_US(Counts) ((uint32_t)(Counts) / ES_CORE_COUNTS_PER_US)
+#define ES_COUNTS_TO_MS(Counts) \
+  ((uint32_t)(Counts) / (ES_CORE_COUNTS_PER_US * 1000))
+
+// called from the tick response, with the timer number, by a callback timer
+typedef void (*ES_TimerCallback_t)(uint8_t WhichTimer);
+
 void ES_Timer_Init(TimerRate_t Rate);
 void ES_Timer_Tick_Resp(void);
-ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime);
-ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime);
+void ES_Timer_Advance(uint32_t Ticks);
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint32_t NewTime);
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint32_t NewTime);
 ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num);
 ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num);
+ES_TimerReturn_t ES_Timer_InitPeriodic(uint8_t Num, uint32_t Period);
+uint16_t ES_Timer_GetMissed(uint8_t Num);
+void ES_Timer_TimeoutDispatched(uint16_t Num);
+ES_TimerReturn_t ES_Timer_SetCallback(uint8_t Num, ES_TimerCallback_t Callback);
+uint32_t ES_Timer_GetCallbackMax(uint8_t Num);
+ES_TimerHandle_t ES_Timer_Alloc(uint8_t WhichService);
+ES_TimerReturn_t ES_Timer_Free(ES_TimerHandle_t Handle);
 uint16_t ES_Timer_GetTime(void);
+uint32_t ES_Timer_TicksToNextExpiry(void);
+uint64_t ES_GetTime64(void);
+uint64_t ES_GetTime_us(void);
+uint64_t ES_Time64ToUs(uint64_t Counts);
+uint64_t ES_Time64ToMs(uint64_t Counts);
 
 #endif   /* ES_Timers_H */
 /*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,57 @@
+/****************************************************************************
+ Module
+     ES_Trace.h
+ Description
+     header file for the optional binary trace of framework activity
+ Notes
+     Everything here compiles to nothing unless ES_TRACE is defined in
+     ES_Configure.h. See ES_Trace.c for the format of the frames sent over
+     the UART and Tools/es_trace_decode.py to turn them into a timeline.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/16/26 18:00 mss      added ES_TRACE_PUBLISH
+ 10/16/26 17:00 mss      started coding
+*****************************************************************************/
+#ifndef ES_Trace_H
+#define ES_Trace_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+// the kinds of trace record, these values are part of the frame format
+// and must match the decoder
+typedef enum
+{
+  ES_TRACE_POST = 1,        // ES_PostToService, Service = target
+  ES_TRACE_POST_LIFO,       // ES_PostToServiceLIFO, Service = target
+  ES_TRACE_POST_ISR,        // ES_PostToServiceFromISR, Service = target
+  ES_TRACE_POST_ALL,        // ES_PostAll, Service is not used
+  ES_TRACE_DEQUEUE,         // ES_Run took the event from Service's queue
+  ES_TRACE_RUN_START,       // Service's run function called with the event
+  ES_TRACE_RUN_END,         // Service's run function returned the event
+  ES_TRACE_TIMEOUT,         // timer (in Service) expired
+  ES_TRACE_OVERFLOW,        // EventParam records were lost, buffer was full
+  ES_TRACE_PUBLISH          // ES_Publish, Service is not used
+}ES_TraceKind_t;
+
+#ifdef ES_TRACE
+
+// hooks used by the framework
+#define ES_TRACE_EVENT(Kind, Which, Event) \
+  ES_Trace_Record((Kind), (Which), (Event))
+#define ES_TRACE_DRAIN() ES_Trace_Drain()
+
+void ES_Trace_Record(ES_TraceKind_t Kind, uint8_t WhichService,
+    ES_Event_t TheEvent);
+void ES_Trace_Drain(void);
+
+#else
+
+#define ES_TRACE_EVENT(Kind, Which, Event)
+#define ES_TRACE_DRAIN()
+
+#endif /* ES_TRACE */
+
+#endif /* ES_Trace_H */
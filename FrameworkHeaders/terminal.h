@@ -23,16 +23,28 @@ extern "C" {
     
 // map the generic functions for testing the serial port to actual functions
 // for this platform.
+#ifdef ES_HOST_PORT
+#define IsNewKeyReady() Terminal_IsRxData()
+#define kbhit() Terminal_IsRxData()
+#else
 #define IsNewKeyReady() (U1STAbits.URXDA)
+#define kbhit() (U1STAbits.URXDA)
+#endif
 #define GetNewKey Terminal_ReadByte
 //#define putch Terminal_WriteByte
-#define kbhit() (U1STAbits.URXDA)
     
 void Terminal_HWInit(void);
 uint8_t Terminal_ReadByte(void);
 void Terminal_WriteByte(uint8_t txByte);
 bool Terminal_IsRxData(void);
 void Terminal_MoveBuffer2UART( void );
+bool Terminal_IsTxEmpty( void );
+void Terminal_Flush( void );
+#ifdef ES_HOST_PORT
+// called by _HW_Process_Pending_Ints on the host port in place of the
+// receive interrupt
+void Terminal_HostPoll( void );
+#endif
 
 #ifdef __XC16__  // DEPRICATED, USE FOR xc16 of xc32 v1.34 or lower
 int write(int handle, void *buffer, unsigned int len);
@@ -5,9 +5,17 @@
      source file for the module to call the User event checking routines
  Notes
      Users should not modify the contents of this file.
+     Each checker in EVENT_CHECK_LIST has a priority and a poll period. On
+     each pass every checker that is due is run, in priority order, rather
+     than stopping at the first one that found an event, so that a checker
+     that keeps finding events can not starve the ones after it. A checker
+     is due when its period has passed since it last ran, or when an ISR
+     has called ES_CheckerWake for it since then.
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 04:00 mss     checkers are run by priority, rate limited by their
+                        periods and can be woken from an ISR
                 jec     out all user modifications into ES_Configure
  10/16/11 12:32 jec      started coding
 *****************************************************************************/
@@ -15,6 +23,7 @@
 #include "ES_Configure.h"
 #include "ES_Events.h"
 #include "ES_General.h"
+#include "ES_Timers.h"
 #include "ES_CheckEvents.h"
 
 // Include the header files for the module(s) with your event checkers.
@@ -22,14 +31,80 @@
 
 #include "EventCheckWrapper.h"
 
-// Fill in this array with the names of your event checking functions
+// ES_NUM_CHECKERS is an enum, so count the list again for the preprocessor
+#define ES_CHECKER_COUNT(Func, Priority, Period) + 1
+#if (0 EVENT_CHECK_LIST(ES_CHECKER_COUNT)) > 32
+#error "EVENT_CHECK_LIST can have at most 32 checkers"
+#endif
 
-static CheckFunc *const ES_EventList[] = {
-  EVENT_CHECK_LIST
+/*----------------------------- Module Defines ----------------------------*/
+#define CheckerBitOf(n) ((uint32_t)1 << (n))
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  CheckFunc *Func;
+  uint8_t   Priority;   // 0 is run first
+  uint16_t  Period;     // ticks, or ES_CHECK_EVERY_PASS or ES_CHECK_ON_WAKE
+}CheckerDesc_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool IsDue(uint8_t Which, uint16_t Now);
+
+/*---------------------------- Module Variables ---------------------------*/
+// Filled in from EVENT_CHECK_LIST in ES_Configure.h
+#define ES_CHECKER_DESC(Func, Priority, Period) { Func, Priority, Period },
+
+static CheckerDesc_t const ES_EventList[] = {
+  EVENT_CHECK_LIST(ES_CHECKER_DESC)
 };
 
+// the checkers in the order that they are run, by priority
+static uint8_t CheckOrder[ES_NUM_CHECKERS];
+// the tick that each checker was last run on
+static uint16_t LastRun[ES_NUM_CHECKERS];
+// a bit for each checker that an ISR has woken, set with an atomic OR
+static uint32_t WokenCheckers;
+
 // Implementation for public functions
 
+/****************************************************************************
+ Function
+   ES_InitCheckers
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   sorts the checkers by priority and makes all of them due, so that each
+   one is run on the first pass
+ Notes
+   called from ES_Initialize, after the timers are started
+ Author
+   M. Saboo, 10/17/26, 04:00
+****************************************************************************/
+void ES_InitCheckers(void)
+{
+  uint16_t  Now = ES_Timer_GetTime();
+  uint8_t   i;
+  uint8_t   j;
+
+  // insertion sort, which keeps checkers of the same priority in the order
+  // that they are in EVENT_CHECK_LIST
+  for (i = 0; i < ES_NUM_CHECKERS; i++)
+  {
+    for (j = i; (j > 0) &&
+        (ES_EventList[CheckOrder[j - 1]].Priority > ES_EventList[i].Priority);
+        j--)
+    {
+      CheckOrder[j] = CheckOrder[j - 1];
+    }
+    CheckOrder[j]   = i;
+    LastRun[i]      = Now - ES_EventList[i].Period;
+  }
+  WokenCheckers = 0;
+}
+
 /****************************************************************************
  Function
    ES_CheckUserEvents
@@ -38,31 +113,148 @@ static CheckFunc *const ES_EventList[] = {
  Returns
    bool: true if any of the user event checkers returned true, false otherwise
  Description
-   loop through the EF_EventList array executing the event checking functions
+   runs each checker that is due, by priority
  Notes
-
+   The wake flags are taken all at once, a wake that comes in while the
+   checkers are running is for the next pass.
  Author
    J. Edward Carryer, 10/25/11, 08:55
 ****************************************************************************/
 bool ES_CheckUserEvents(void)
 {
-  uint8_t i;
-  // loop through the array executing the event checking functions
-  for (i = 0; i < ARRAY_SIZE(ES_EventList); i++)
+  uint32_t  Woken;
+  uint16_t  Now;
+  uint8_t   i;
+  uint8_t   Which;
+  bool      FoundEvent = false;
+
+  Now   = ES_Timer_GetTime();
+  Woken = __atomic_exchange_n(&WokenCheckers, 0, __ATOMIC_ACQUIRE);
+  // loop through the checkers by priority executing those that are due
+  for (i = 0; i < ES_NUM_CHECKERS; i++)
   {
-    if (ES_EventList[i]() == true)
+    Which = CheckOrder[i];
+    if (((Woken & CheckerBitOf(Which)) != 0) || IsDue(Which, Now))
     {
-      break; // found a new event, so process it first
+      LastRun[Which] = Now;
+      if (ES_EventList[Which].Func() == true)
+      {
+        FoundEvent = true;  // but give the rest their turn too
+      }
     }
   }
-  if (i == ARRAY_SIZE(ES_EventList))   // if no new events
+  return FoundEvent;
+}
+
+/****************************************************************************
+ Function
+   ES_CheckerWake
+ Parameters
+   ES_Checker_t : Which, the checker to run on the next pass
+ Returns
+   nothing
+ Description
+   has the checker run on the next pass, whether or not its period is up
+ Notes
+   Meant to be called from the ISR that sets the flag that the checker
+   tests, so that a checker with a period of ES_CHECK_ON_WAKE is only run
+   when there is something for it to find. Safe from any ISR priority.
+ Author
+   M. Saboo, 10/17/26, 04:00
+****************************************************************************/
+void ES_CheckerWake(ES_Checker_t Which)
+{
+  if (Which < ES_NUM_CHECKERS)
   {
-    return false;
+    __atomic_fetch_or(&WokenCheckers, CheckerBitOf(Which), __ATOMIC_RELEASE);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_AreCheckersWoken
+ Parameters
+   None
+ Returns
+   bool, true if any checker has been woken since the last pass
+ Description
+   lets ES_Run see, with ints disabled, that it should not go to sleep
+ Author
+   M. Saboo, 10/17/26, 04:00
+****************************************************************************/
+bool ES_AreCheckersWoken(void)
+{
+  return __atomic_load_n(&WokenCheckers, __ATOMIC_ACQUIRE) != 0;
+}
+
+/****************************************************************************
+ Function
+   ES_CheckerTicksToNextDue
+ Parameters
+   None
+ Returns
+   uint32_t, the ticks until the next checker with a period is due, 0 if
+   one is due now, UINT32_MAX if there are none
+ Description
+   used by ES_Run with ES_TICKLESS to wake in time for the next checker
+ Notes
+   Checkers run on every pass or only when woken do not count. The first
+   are run whenever the CPU is awake anyway, and the ISR that wakes the
+   second also wakes the CPU.
+ Author
+   M. Saboo, 10/17/26, 04:00
+****************************************************************************/
+uint32_t ES_CheckerTicksToNextDue(void)
+{
+  uint32_t  Soonest = UINT32_MAX;
+  uint16_t  Now     = ES_Timer_GetTime();
+  uint16_t  Period;
+  uint16_t  Elapsed;
+  uint8_t   i;
+
+  for (i = 0; i < ES_NUM_CHECKERS; i++)
+  {
+    Period = ES_EventList[i].Period;
+    if ((Period == ES_CHECK_EVERY_PASS) || (Period == ES_CHECK_ON_WAKE))
+    {
+      continue;
+    }
+    Elapsed = Now - LastRun[i];
+    if (Elapsed >= Period)
+    {
+      return 0;
+    }
+    if ((uint32_t)(Period - Elapsed) < Soonest)
+    {
+      Soonest = Period - Elapsed;
+    }
   }
-  else
+  return Soonest;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   IsDue
+ Parameters
+   uint8_t : Which, the checker
+   uint16_t : Now, the current tick
+ Returns
+   bool, true if the checker's period has passed since it last ran
+ Author
+   M. Saboo, 10/17/26, 04:00
+****************************************************************************/
+static bool IsDue(uint8_t Which, uint16_t Now)
+{
+  uint16_t Period = ES_EventList[Which].Period;
+
+  if (Period == ES_CHECK_ON_WAKE)
   {
-    return true;
+    return false;
   }
+  return (uint16_t)(Now - LastRun[Which]) >= Period;
 }
 
 /*------------------------------- Footnotes -------------------------------*/
@@ -1,3 +1,4 @@
+//#define LATENCY_BENCH
 /****************************************************************************
  Module
      EF_Framework.c
@@ -8,6 +9,38 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 10:50 mss     ES_SCHED_AGING ages bands of services, and services
+                        of the same age in a band take turns
+ 10/17/26 10:20 mss     the ISR latency benchmark moved here from ES_Queue.c, it
+                        now measures ES_PostToServiceFromISR into service 0
+ 10/17/26 10:10 mss     coalescing posts no longer rewrite the event at the
+                        head of the queue, ES_Run may have already taken it
+ 10/17/26 04:00 mss     ES_Initialize sets up the event checkers, and with
+                        ES_TICKLESS ES_Run wakes for the next one that is due
+ 10/16/26 23:00 mss     with ES_TICKLESS, ES_Run stops the tick and WAITs when
+                        it has nothing to do, see IdleUntilNeeded
+ 10/16/26 21:00 mss     ES_Run tells the timers when it runs an ES_TIMEOUT, for
+                        the periodic timers
+ 10/16/26 18:00 mss     added publish/subscribe routing, ES_Publish posts
+                        only to the services subscribed to the event type
+ 10/16/26 17:00 mss     added the ES_TRACE hooks
+ 10/16/26 16:00 mss     added the ES_PROFILE hooks and ES_GetQueueSize
+ 10/16/26 15:00 mss     up to 64 services. The per-service tables are generated
+                        with ES_FOR_EACH_SERVICE and Ready is now a two level
+                        bitmap searched with the clz instruction
+ 10/16/26 14:00 mss     the pick of the next service is now made by the
+                        ES_SCHED_POLICY, added worst case wait times
+ 10/16/26 13:05 mss     posts of ES_COALESCING_EVENTS types overwrite an
+                        event of the same type already waiting in the queue
+ 10/16/26 12:10 mss     ES_Run may now run a batch of up to SERV_n_BATCH events
+                        for a service before going back to the pending ints
+ 10/16/26 11:20 mss     service queues are now generated per service, sized to
+                        a power of 2 and wrapped with a mask. ES_Run dispatches
+                        through a switch so that the DeQueue is inlined and the
+                        run function is called directly
+ 10/16/26 10:05 mss     added per-service queue kinds, ES_PostToServiceFromISR
+                        and made the updates to Ready atomic so that ISRs
+                        can post without events being stranded
  08/21/17 13:18 jec     added conditional call to initialize the port lines
                         for the hardware debugging of the framework/apps
  12/19/16 20:18 jec      changed includes to accomodate the change to a fixed
@@ -38,6 +71,9 @@
 // This gets you the prototypes for the public service functions.
 
 #include "ES_ServiceHeaders.h"
+#include "ES_ServiceList.h"
+#include "ES_Profile.h"
+#include "ES_Trace.h"
 // new at V2.4
 #include "EventCheckWrapper.h"
 
@@ -58,20 +94,115 @@ typedef RunFunc_t   *pRunFunc;
 
 #define NULL_INIT_FUNC ((pInitFunc)0)
 
+// the entry for service n in ServDescList
+#define ES_SERV_DESC(n) { SERV_##n##_INIT, SERV_##n##_RUN },
+
 typedef struct
 {
   InitFunc_t *InitFunc;       // Service Initialization function
   RunFunc_t *RunFunc;         // Service Run function
 }ES_ServDesc_t;
 
+// The service queues are rings of a power of 2 entries (at most 128) with
+// free running indices. The number of entries is (PutIndex - GetIndex)
+// and an index is turned into a slot number with the Mask. PutIndex is
+// only written by posters and GetIndex only by ES_Run (and recalls).
+typedef struct
+{
+  uint8_t PutIndex;
+  uint8_t GetIndex;
+}ES_QueueIndex_t;
+
 typedef struct
 {
-  ES_Event_t *pMem;       // pointer to the memory
-  uint8_t Size;         // how big is it
+  ES_Event_t *pSlots;         // the entries
+  ES_QueueIndex_t *pIndex;    // the put & get indices for those entries
+  uint8_t Mask;               // number of entries - 1
+  ES_QueueKind_t Kind;        // locked or lock-free SPSC
 }ES_QueueDesc_t;
 
+// smallest power of 2 that will hold n entries, for n from 1 to 128
+#define ES_QUEUE_POW2(n) \
+  ((n) <= 1 ? 1 : (n) <= 2 ? 2 : (n) <= 4 ? 4 : (n) <= 8 ? 8 : \
+   (n) <= 16 ? 16 : (n) <= 32 ? 32 : (n) <= 64 ? 64 : 128)
+
+// the entry for service n in EventQueues
+#define ES_QUEUE_DESC(n) \
+  { Queue##n, &QueueIndex##n, ARRAY_SIZE(Queue##n) - 1, SERV_##n##_QUEUE_KIND },
+
+// Generates the storage and indices for the queue of service n, along with
+// an inline DeQueue specialized to its size for use in ES_Run. The typedef
+// stops the build if SERV_n_QUEUE_SIZE is too big for the 8-bit indices.
+#define ES_SERVICE_QUEUE(n) \
+  typedef char Queue##n##SizeCheck[(SERV_##n##_QUEUE_SIZE <= 128) ? 1 : -1]; \
+  static ES_Event_t Queue##n[ES_QUEUE_POW2(SERV_##n##_QUEUE_SIZE)]; \
+  static ES_QueueIndex_t QueueIndex##n; \
+  static inline uint8_t DeQueue##n(ES_Event_t *pReturnEvent) \
+  { \
+    return DeQueueFast(Queue##n, &QueueIndex##n, \
+             ARRAY_SIZE(Queue##n) - 1, pReturnEvent); \
+  }
+
+// one case of the dispatch switch in ES_Run. The run function is called
+// directly, rather than through ServDescList. Up to SERV_n_BATCH events
+// are run back to back, stopping early if the queue empties, the service
+// reports an error or a higher priority service becomes Ready
+#define ES_DISPATCH(n) \
+  case n: \
+  { \
+    uint8_t Budget = SERV_##n##_BATCH; \
+    do \
+    { \
+      if (DeQueue##n(&ThisEvent) == 0) \
+      { \
+        MarkQueueEmpty(n); \
+        Budget = 1; \
+      } \
+      ES_TRACE_EVENT(ES_TRACE_DEQUEUE, n, ThisEvent); \
+      if (ThisEvent.EventType == ES_TIMEOUT) \
+      { \
+        ES_Timer_TimeoutDispatched(ThisEvent.EventParam); \
+      } \
+      ES_TRACE_EVENT(ES_TRACE_RUN_START, n, ThisEvent); \
+      ES_PROFILE_RUN_START(); \
+      RunResult = SERV_##n##_RUN(ThisEvent); \
+      ES_PROFILE_RUN_END(n); \
+      ES_TRACE_EVENT(ES_TRACE_RUN_END, n, ThisEvent); \
+    } while ((--Budget != 0) && (RunResult.EventType == ES_NO_EVENT) && \
+             !IsHigherReady(n)); \
+  } \
+  break;
+
+// The Ready services are kept in a two level bitmap. Bit (n % 32) of
+// ReadyWords[n / 32] is set while service n has events waiting, and bit w
+// of ReadyGroups is set while ReadyWords[w] is not 0. The highest Ready
+// service is then two MSB lookups, whatever the number of services.
+#define READY_WORDS ((NUM_SERVICES + 31) / 32)
+#define ReadyWordOf(n) ((n) >> 5)
+#define ReadyBitOf(n) ((uint32_t)1 << ((n) & 31))
+
 /*---------------------------- Module Functions ---------------------------*/
 //static bool CheckSystemEvents( void );
+static inline bool EnQueueFast(ES_Event_t *pSlots, ES_QueueIndex_t *pIndex,
+    uint8_t Mask, ES_Event_t Event2Add);
+static inline uint8_t DeQueueFast(ES_Event_t *pSlots, ES_QueueIndex_t *pIndex,
+    uint8_t Mask, ES_Event_t *pReturnEvent);
+static inline void MarkQueueEmpty(uint8_t WhichService);
+static bool PostFromTask(uint8_t WhichService, ES_Event_t TheEvent);
+static inline void SetReady(uint8_t WhichService);
+static inline void ClrReady(uint8_t WhichService);
+static inline bool IsReady(uint8_t WhichService);
+static inline bool IsHigherReady(uint8_t WhichService);
+static inline uint8_t HighestReady(void);
+static inline uint8_t PickService(void);
+static inline void NoteWait(uint8_t WhichService);
+#if ES_SCHED_POLICY == ES_SCHED_AGING
+static inline uint32_t AgedPriority(uint8_t WhichService, uint32_t Now);
+#endif
+static bool CoalesceQueued(ES_QueueDesc_t const *pQueue, ES_Event_t TheEvent);
+#ifdef ES_TICKLESS
+static void IdleUntilNeeded(void);
+#endif
 
 /*---------------------------- Module Variables ---------------------------*/
 /****************************************************************************/
@@ -82,160 +213,56 @@ typedef struct
 // priority with higher indices
 
 static ES_ServDesc_t const ServDescList[] =
-{ { SERV_0_INIT, SERV_0_RUN } /* lowest priority  always present */
-#if NUM_SERVICES > 1
-  , { SERV_1_INIT, SERV_1_RUN }
-#endif
-#if NUM_SERVICES > 2
-  , { SERV_2_INIT, SERV_2_RUN }
-#endif
-#if NUM_SERVICES > 3
-  , { SERV_3_INIT, SERV_3_RUN }
-#endif
-#if NUM_SERVICES > 4
-  , { SERV_4_INIT, SERV_4_RUN }
-#endif
-#if NUM_SERVICES > 5
-  , { SERV_5_INIT, SERV_5_RUN }
-#endif
-#if NUM_SERVICES > 6
-  , { SERV_6_INIT, SERV_6_RUN }
-#endif
-#if NUM_SERVICES > 7
-  , { SERV_7_INIT, SERV_7_RUN }
-#endif
-#if NUM_SERVICES > 8
-  , { SERV_8_INIT, SERV_8_RUN }
-#endif
-#if NUM_SERVICES > 9
-  , { SERV_9_INIT, SERV_9_RUN }
-#endif
-#if NUM_SERVICES > 10
-  , { SERV_10_INIT, SERV_10_RUN }
-#endif
-#if NUM_SERVICES > 11
-  , { SERV_11_INIT, SERV_11_RUN }
-#endif
-#if NUM_SERVICES > 12
-  , { SERV_12_INIT, SERV_12_RUN }
-#endif
-#if NUM_SERVICES > 13
-  , { SERV_13_INIT, SERV_13_RUN }
-#endif
-#if NUM_SERVICES > 14
-  , { SERV_14_INIT, SERV_14_RUN }
-#endif
-#if NUM_SERVICES > 15
-  , { SERV_15_INIT, SERV_15_RUN }
-#endif
+{
+  ES_FOR_EACH_SERVICE(ES_SERV_DESC)
 };
 
 /****************************************************************************/
-// The queues for the services
-
-static ES_Event_t Queue0[SERV_0_QUEUE_SIZE + 1];
-#if NUM_SERVICES > 1
-static ES_Event_t Queue1[SERV_1_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 2
-static ES_Event_t Queue2[SERV_2_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 3
-static ES_Event_t Queue3[SERV_3_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 4
-static ES_Event_t Queue4[SERV_4_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 5
-static ES_Event_t Queue5[SERV_5_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 6
-static ES_Event_t Queue6[SERV_6_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 7
-static ES_Event_t Queue7[SERV_7_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 8
-static ES_Event_t Queue8[SERV_8_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 9
-static ES_Event_t Queue9[SERV_9_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 10
-static ES_Event_t Queue10[SERV_10_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 11
-static ES_Event_t Queue11[SERV_11_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 12
-static ES_Event_t Queue12[SERV_12_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 13
-static ES_Event_t Queue13[SERV_13_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 14
-static ES_Event_t Queue14[SERV_14_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 15
-static ES_Event_t Queue15[SERV_15_QUEUE_SIZE + 1];
-#endif
+// The queues for the services, each rounded up to a power of 2 entries so
+// that the indices wrap with a mask rather than a divide
+ES_FOR_EACH_SERVICE(ES_SERVICE_QUEUE)
 
 /****************************************************************************/
 // array of queue descriptors for posting by priority level
 
-static ES_QueueDesc_t const EventQueues[NUM_SERVICES] = {
-  { Queue0, ARRAY_SIZE(Queue0) }
-#if NUM_SERVICES > 1
-  , { Queue1, ARRAY_SIZE(Queue1) }
-#endif
-#if NUM_SERVICES > 2
-  , { Queue2, ARRAY_SIZE(Queue2) }
-#endif
-#if NUM_SERVICES > 3
-  , { Queue3, ARRAY_SIZE(Queue3) }
-#endif
-#if NUM_SERVICES > 4
-  , { Queue4, ARRAY_SIZE(Queue4) }
-#endif
-#if NUM_SERVICES > 5
-  , { Queue5, ARRAY_SIZE(Queue5) }
-#endif
-#if NUM_SERVICES > 6
-  , { Queue6, ARRAY_SIZE(Queue6) }
-#endif
-#if NUM_SERVICES > 7
-  , { Queue7, ARRAY_SIZE(Queue7) }
-#endif
-#if NUM_SERVICES > 8
-  , { Queue8, ARRAY_SIZE(Queue8) }
-#endif
-#if NUM_SERVICES > 9
-  , { Queue9, ARRAY_SIZE(Queue9) }
-#endif
-#if NUM_SERVICES > 10
-  , { Queue10, ARRAY_SIZE(Queue10) }
-#endif
-#if NUM_SERVICES > 11
-  , { Queue11, ARRAY_SIZE(Queue11) }
-#endif
-#if NUM_SERVICES > 12
-  , { Queue12, ARRAY_SIZE(Queue12) }
-#endif
-#if NUM_SERVICES > 13
-  , { Queue13, ARRAY_SIZE(Queue13) }
-#endif
-#if NUM_SERVICES > 14
-  , { Queue14, ARRAY_SIZE(Queue14) }
-#endif
-#if NUM_SERVICES > 15
-  , { Queue15, ARRAY_SIZE(Queue15) }
-#endif
+static ES_QueueDesc_t const EventQueues[NUM_SERVICES] =
+{
+  ES_FOR_EACH_SERVICE(ES_QUEUE_DESC)
 };
 
 /****************************************************************************/
-// Variable used to keep track of which queues have events in them
+// The event types that coalesce in the queues, see ES_Configure.h
+#ifdef ES_COALESCING_EVENTS
+static ES_EventType_t const CoalescingEvents[] = { ES_COALESCING_EVENTS };
+#endif
+
+/****************************************************************************/
+// Variables used to keep track of which queues have events in them. They
+// are updated from ISRs as well as from ES_Run, so every read-modify-write
+// is atomic. On the PIC32 these compile to ll/sc loops, which do not need
+// the interrupts turned off.
+
+static volatile uint32_t ReadyGroups;
+static volatile uint32_t ReadyWords[READY_WORDS];
 
-uint16_t Ready;
+// core timer count at which each service last became Ready, and the
+// longest that each has had to wait between becoming Ready and being run
+static uint32_t ReadySince[NUM_SERVICES];
+static uint32_t MaxWait[NUM_SERVICES];
+
+#if (ES_SCHED_POLICY == ES_SCHED_BANDED_RR) || \
+    (ES_SCHED_POLICY == ES_SCHED_AGING)
+#if (ES_SCHED_BAND_SIZE > 32) || (ES_SCHED_BAND_SIZE & (ES_SCHED_BAND_SIZE - 1))
+#error "ES_SCHED_BAND_SIZE must be a power of 2, no more than 32"
+#endif
+// the offset within each band of the service that ran last
+static uint8_t LastInBand[(MAX_NUM_SERVICES + ES_SCHED_BAND_SIZE - 1) /
+    ES_SCHED_BAND_SIZE];
+#endif
+
+// the services subscribed to each event type, laid out like ReadyWords:
+// bit (n % 32) of Subscribers[Type][n / 32] is set if service n subscribes
+static uint32_t Subscribers[ES_NUM_EVENT_TYPES][READY_WORDS];
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -257,6 +284,7 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
 {
   uint8_t i;
   ES_Timer_Init(NewRate);  // start up the timer subsystem
+  ES_InitCheckers();        // and the event checkers, which use its time
   // loop through the list testing for NULL pointers and
   for (i = 0; i < ARRAY_SIZE(ServDescList); i++)
   {
@@ -266,7 +294,8 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
       return FailedPointer; // protect against NULL pointers
     }
     // and initializing the event queues (must happen before running inits)
-    ES_InitQueue(EventQueues[i].pMem, EventQueues[i].Size);
+    EventQueues[i].pIndex->PutIndex = 0;
+    EventQueues[i].pIndex->GetIndex = 0;
     // executing the init functions
     if (ServDescList[i].InitFunc(i) != true)
     {
@@ -302,26 +331,40 @@ ES_Return_t ES_Run(void)
   // make these static to improve speed
   uint8_t         HighestPrior;
   static ES_Event_t ThisEvent;
+  ES_Event_t      RunResult;
 
   while (1)  // stay here unless we detect an error condition
   { // loop through the list executing the run functions for services
     // with a non-empty queue. Process any pending ints before testing
     // Ready
-    while ((_HW_Process_Pending_Ints()) && (Ready != 0))
+    while ((_HW_Process_Pending_Ints()) && (ReadyGroups != 0))
     {
-      HighestPrior = ES_GetMSBitSet(Ready);
-      if (ES_DeQueue(EventQueues[HighestPrior].pMem, &ThisEvent) == 0)
-      {
-        Ready &= BitNum2ClrMask[HighestPrior]; // mark queue as now empty
-      }
+      // with ES_SCHED_STRICT this is the highest priority Ready service
+      HighestPrior = PickService();
+      NoteWait(HighestPrior);
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugSetLine1();
 #endif
-      if (ServDescList[HighestPrior].RunFunc(ThisEvent).EventType !=
-          ES_NO_EVENT)
+      // one case per service, so that the DeQueue is inlined with the size
+      // of that service's queue and its run function is called directly.
+      // Each case may run a batch of events, see ES_DISPATCH
+      switch (HighestPrior)
+      {
+        ES_FOR_EACH_SERVICE(ES_DISPATCH)
+        default:
+        {
+          return FailedIndex;   // Ready had a bit for a missing service
+        }
+      }
+      if (RunResult.EventType != ES_NO_EVENT)
       {
         return FailedRun;
       }
+      // if it still has events, its wait for the next turn starts now
+      if (IsReady(HighestPrior))
+      {
+        ReadySince[HighestPrior] = _CP0_GET_COUNT();
+      }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugClearLine1();
 #endif
@@ -334,6 +377,10 @@ ES_Return_t ES_Run(void)
     if (!ES_CheckUserEvents()) // no new user events
     {
       Terminal_MoveBuffer2UART(); // try moving bytes, if available, to UART
+      ES_TRACE_DRAIN();           // then trace frames, if any, behind them
+#ifdef ES_TICKLESS
+      IdleUntilNeeded();          // and sleep if that left nothing to do
+#endif
     }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
     _HW_DebugClearLine2();
@@ -358,17 +405,15 @@ ES_Return_t ES_Run(void)
 bool ES_PostAll(ES_Event_t ThisEvent)
 {
   uint8_t i;
+
+  ES_TRACE_EVENT(ES_TRACE_POST_ALL, 0, ThisEvent);
   // loop through the list executing the post functions
   for (i = 0; i < ARRAY_SIZE(EventQueues); i++)
   {
-    if (ES_EnQueueFIFO(EventQueues[i].pMem, ThisEvent) != true)
+    if (PostFromTask(i, ThisEvent) != true)
     {
       break; // this is a failed post
     }
-    else
-    {
-      Ready |= BitNum2SetMask[i]; // show queue as non-empty
-    }
   }
   if (i == ARRAY_SIZE(EventQueues))    // if no failures
   {
@@ -397,12 +442,10 @@ bool ES_PostAll(ES_Event_t ThisEvent)
 ****************************************************************************/
 bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
 {
-  if ((WhichService < ARRAY_SIZE(EventQueues)) &&
-      (ES_EnQueueFIFO(EventQueues[WhichService].pMem, TheEvent) ==
-        true))
+  if (WhichService < ARRAY_SIZE(EventQueues))
   {
-    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
-    return true;
+    ES_TRACE_EVENT(ES_TRACE_POST, WhichService, TheEvent);
+    return PostFromTask(WhichService, TheEvent);
   }
   else
   {
@@ -427,22 +470,762 @@ bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
 ****************************************************************************/
 bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent)
 {
-  if ((WhichService < ARRAY_SIZE(EventQueues)) &&
-      (ES_EnQueueLIFO(EventQueues[WhichService].pMem, TheEvent) ==
-        true))
+  ES_QueueDesc_t const  *pQueue;
+  bool                  ReturnVal = false;
+
+  if (WhichService < ARRAY_SIZE(EventQueues))
   {
-    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
-    return true;
+    pQueue = &EventQueues[WhichService];
+    ES_TRACE_EVENT(ES_TRACE_POST_LIFO, WhichService, TheEvent);
+    // this moves the get index, which belongs to ES_Run, and has to agree
+    // with any poster about the space left, so it is done with ints off
+    EnterCritical();
+    if ((uint8_t)(pQueue->pIndex->PutIndex - pQueue->pIndex->GetIndex) <=
+        pQueue->Mask)
+    {
+      pQueue->pIndex->GetIndex--;
+      pQueue->pSlots[pQueue->pIndex->GetIndex & pQueue->Mask] = TheEvent;
+      SetReady(WhichService); // show queue as non-empty
+      ReturnVal = true;
+      ES_PROFILE_POST(WhichService,
+          (uint8_t)(pQueue->pIndex->PutIndex - pQueue->pIndex->GetIndex));
+    }
+    else
+    {
+      ES_PROFILE_POST_FAILED(WhichService);
+    }
+    ExitCritical();
   }
-  else
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_PostToServiceFromISR
+ Parameters
+   uint8_t : Which service to post to (index into ServDescList)
+   ES_Event : The Event to be posted
+ Returns
+   boolean : False if the post function failed during execution
+ Description
+   posts to one of the services' queues from an interrupt response routine
+ Notes
+   If the service has an ES_QUEUE_SPSC queue the post is lock-free and does
+   not block higher priority interrupts. Only one ISR (or ISRs at the same
+   priority level) may post to each SPSC queue this way, see EnQueueFast.
+   Posts from the ES_Run context are made with ints off, so they may share
+   the queue with that ISR. On an ES_QUEUE_LOCKED queue this is the same as
+   ES_PostToService.
+ Author
+   M. Saboo, 10/16/26, 10:05
+****************************************************************************/
+bool ES_PostToServiceFromISR(uint8_t WhichService, ES_Event_t TheEvent)
+{
+  ES_QueueDesc_t const *pQueue;
+
+  if (WhichService < ARRAY_SIZE(EventQueues))
+  {
+    pQueue = &EventQueues[WhichService];
+    ES_TRACE_EVENT(ES_TRACE_POST_ISR, WhichService, TheEvent);
+    if (pQueue->Kind != ES_QUEUE_SPSC)
+    {
+      return PostFromTask(WhichService, TheEvent);
+    }
+    if (EnQueueFast(pQueue->pSlots, pQueue->pIndex, pQueue->Mask, TheEvent))
+    {
+      SetReady(WhichService); // show queue as non-empty
+      ES_PROFILE_POST(WhichService,
+          (uint8_t)(pQueue->pIndex->PutIndex - pQueue->pIndex->GetIndex));
+      return true;
+    }
+    ES_PROFILE_POST_FAILED(WhichService);
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+   ES_Subscribe
+ Parameters
+   uint8_t : Which service is subscribing
+   ES_EventType_t : the type of event that it wants to receive
+ Returns
+   boolean : False if the service or event type is out of range
+ Description
+   adds the service to the subscribers to the event type, so that it is
+   posted every event of that type published with ES_Publish
+ Notes
+   normally called from the service's init function
+ Author
+   M. Saboo, 10/16/26, 18:00
+****************************************************************************/
+bool ES_Subscribe(uint8_t WhichService, ES_EventType_t EventType)
+{
+  if ((WhichService >= NUM_SERVICES) || (EventType >= ES_NUM_EVENT_TYPES))
   {
     return false;
   }
+  __atomic_fetch_or(&Subscribers[EventType][ReadyWordOf(WhichService)],
+      ReadyBitOf(WhichService), __ATOMIC_RELAXED);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Unsubscribe
+ Parameters
+   uint8_t : Which service is unsubscribing
+   ES_EventType_t : the type of event that it no longer wants
+ Returns
+   boolean : False if the service or event type is out of range
+ Description
+   removes the service from the subscribers to the event type
+ Notes
+   events of that type already in the service's queue are still delivered
+ Author
+   M. Saboo, 10/16/26, 18:00
+****************************************************************************/
+bool ES_Unsubscribe(uint8_t WhichService, ES_EventType_t EventType)
+{
+  if ((WhichService >= NUM_SERVICES) || (EventType >= ES_NUM_EVENT_TYPES))
+  {
+    return false;
+  }
+  __atomic_fetch_and(&Subscribers[EventType][ReadyWordOf(WhichService)],
+      ~ReadyBitOf(WhichService), __ATOMIC_RELAXED);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Publish
+ Parameters
+   ES_Event : The Event to be published
+ Returns
+   boolean : False if any of the posts failed, or the event type is out of
+             range
+ Description
+   posts the event to every service subscribed to its type, highest
+   priority first. Unlike ES_PostAll the services that did not subscribe
+   never see it, and a failed post does not stop the rest.
+ Notes
+   publishing a type that nobody subscribes to is not an error
+ Author
+   M. Saboo, 10/16/26, 18:00
+****************************************************************************/
+bool ES_Publish(ES_Event_t ThisEvent)
+{
+  uint32_t  Pending;
+  uint8_t   Word;
+  uint8_t   Bit;
+  bool      ReturnVal = true;
+
+  if (ThisEvent.EventType >= ES_NUM_EVENT_TYPES)
+  {
+    return false;
+  }
+  ES_TRACE_EVENT(ES_TRACE_PUBLISH, 0, ThisEvent);
+  Word = READY_WORDS;
+  while (Word-- != 0)
+  {
+    Pending = __atomic_load_n(&Subscribers[ThisEvent.EventType][Word],
+        __ATOMIC_RELAXED);
+    while (Pending != 0)
+    {
+      Bit     = ES_MSBitOfNonZero(Pending);
+      Pending &= ~((uint32_t)1 << Bit);
+      if (PostFromTask((uint8_t)((Word << 5) + Bit), ThisEvent) != true)
+      {
+        ReturnVal = false;  // this is a failed post
+      }
+    }
+  }
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_GetMaxWait
+ Parameters
+   uint8_t : Which service (index into ServDescList)
+ Returns
+   uint32_t : longest wait seen, in core timer counts (50nS)
+ Description
+   reports the worst case time that the service has spent Ready but not
+   running, since startup or the last call to ES_ClearMaxWaits
+ Notes
+   a wait ends when the service is picked to run a (batch of) event(s), so
+   this includes the time taken by the services that ran ahead of it
+ Author
+   M. Saboo, 10/16/26, 14:00
+****************************************************************************/
+uint32_t ES_GetMaxWait(uint8_t WhichService)
+{
+  if (WhichService < ARRAY_SIZE(MaxWait))
+  {
+    return MaxWait[WhichService];
+  }
+  return 0;
+}
+
+/****************************************************************************
+ Function
+   ES_GetQueueSize
+ Parameters
+   uint8_t : Which service (index into ServDescList)
+ Returns
+   uint8_t : number of entries that its queue can hold
+ Description
+   SERV_n_QUEUE_SIZE rounded up to the power of 2 actually allocated
+ Author
+   M. Saboo, 10/16/26, 16:00
+****************************************************************************/
+uint8_t ES_GetQueueSize(uint8_t WhichService)
+{
+  if (WhichService < ARRAY_SIZE(EventQueues))
+  {
+    return EventQueues[WhichService].Mask + 1;
+  }
+  return 0;
+}
+
+/****************************************************************************
+ Function
+   ES_ClearMaxWaits
+ Parameters
+   None
+ Returns
+   None
+ Description
+   resets the worst case wait times of all of the services
+ Author
+   M. Saboo, 10/16/26, 14:00
+****************************************************************************/
+void ES_ClearMaxWaits(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < ARRAY_SIZE(MaxWait); i++)
+  {
+    MaxWait[i] = 0;
+  }
 }
 
 //*********************************
 // private functions
 //*********************************
+/****************************************************************************
+ Function
+   SetReady
+ Parameters
+   uint8_t : Which service now has an event in its queue
+ Returns
+   nothing
+ Description
+   sets the Ready bit for the service and, if it was not already set,
+   notes the time so that ES_Run can tell how long it waited
+ Notes
+   may be called from an ISR. An ISR cannot be interrupted by ES_Run, so
+   the bit and the time always look consistent to ES_Run
+ Author
+   M. Saboo, 10/16/26, 14:00
+****************************************************************************/
+static inline void SetReady(uint8_t WhichService)
+{
+  uint32_t Now = _CP0_GET_COUNT();
+  uint32_t WasReady;
+
+  WasReady = __atomic_fetch_or(&ReadyWords[ReadyWordOf(WhichService)],
+      ReadyBitOf(WhichService), __ATOMIC_RELEASE);
+  if ((WasReady & ReadyBitOf(WhichService)) == 0)
+  {
+    ReadySince[WhichService] = Now;
+  }
+  if (WasReady == 0)
+  {
+    __atomic_fetch_or(&ReadyGroups, ReadyBitOf(ReadyWordOf(WhichService)),
+        __ATOMIC_RELEASE);
+  }
+}
+
+/****************************************************************************
+ Function
+   ClrReady
+ Parameters
+   uint8_t : Which service's queue is now empty
+ Returns
+   nothing
+ Description
+   clears the Ready bit for the service, and its group bit if it was the
+   last one in its word
+ Notes
+   only called from ES_Run. An ISR may set a bit in the word between the
+   two steps, so the word is looked at again after clearing the group.
+ Author
+   M. Saboo, 10/16/26, 15:00
+****************************************************************************/
+static inline void ClrReady(uint8_t WhichService)
+{
+  uint8_t Word = ReadyWordOf(WhichService);
+
+  if (__atomic_and_fetch(&ReadyWords[Word], ~ReadyBitOf(WhichService),
+      __ATOMIC_ACQ_REL) == 0)
+  {
+    __atomic_fetch_and(&ReadyGroups, ~ReadyBitOf(Word), __ATOMIC_ACQ_REL);
+    if (ReadyWords[Word] != 0)
+    {
+      __atomic_fetch_or(&ReadyGroups, ReadyBitOf(Word), __ATOMIC_RELEASE);
+    }
+  }
+}
+
+/****************************************************************************
+ Function
+   IsReady
+ Parameters
+   uint8_t : Which service to test
+ Returns
+   bool : true if the service has events waiting
+ Author
+   M. Saboo, 10/16/26, 15:00
+****************************************************************************/
+static inline bool IsReady(uint8_t WhichService)
+{
+  return (ReadyWords[ReadyWordOf(WhichService)] & ReadyBitOf(WhichService))
+         != 0;
+}
+
+/****************************************************************************
+ Function
+   IsHigherReady
+ Parameters
+   uint8_t : Which service to compare against
+ Returns
+   bool : true if any service of higher priority has events waiting
+ Notes
+   shifts in two steps so that service 31 (63) does not shift by 32
+ Author
+   M. Saboo, 10/16/26, 15:00
+****************************************************************************/
+static inline bool IsHigherReady(uint8_t WhichService)
+{
+  uint8_t Word = ReadyWordOf(WhichService);
+
+  return (((ReadyWords[Word] >> (WhichService & 31)) >> 1) != 0) ||
+         (((ReadyGroups >> Word) >> 1) != 0);
+}
+
+/****************************************************************************
+ Function
+   HighestReady
+ Parameters
+   None
+ Returns
+   uint8_t : the highest priority service with events waiting
+ Notes
+   only called while ReadyGroups != 0
+ Author
+   M. Saboo, 10/16/26, 15:00
+****************************************************************************/
+static inline uint8_t HighestReady(void)
+{
+  uint8_t Word = ES_MSBitOfNonZero(ReadyGroups);
+
+  return (uint8_t)((Word << 5) + ES_MSBitOfNonZero(ReadyWords[Word]));
+}
+
+/****************************************************************************
+ Function
+   PickService
+ Parameters
+   None
+ Returns
+   uint8_t : the Ready service that ES_Run should run next
+ Description
+   applies the ES_SCHED_POLICY from ES_Configure.h to the Ready services
+ Notes
+   only called while Ready != 0
+   With ES_SCHED_AGING, services are banded as for ES_SCHED_BANDED_RR and
+   a service's effective priority is its band plus the levels it has aged,
+   so an older service runs ahead of a younger one in the same band, and
+   those of the same age take turns.
+ Author
+   M. Saboo, 10/16/26, 14:00
+****************************************************************************/
+static inline uint8_t PickService(void)
+{
+#if ES_SCHED_POLICY == ES_SCHED_STRICT
+  return HighestReady();
+
+#elif ES_SCHED_POLICY == ES_SCHED_BANDED_RR
+  uint8_t Base;
+  uint8_t Band;
+  uint8_t Offset;
+  uint8_t i;
+
+  // start of the highest band that has a Ready service in it
+  Base  = HighestReady() & ~(ES_SCHED_BAND_SIZE - 1);
+  Band  = Base / ES_SCHED_BAND_SIZE;
+  // take the next one down from the last to run, wrapping within the band
+  for (i = 1; i <= ES_SCHED_BAND_SIZE; i++)
+  {
+    Offset = (LastInBand[Band] - i) & (ES_SCHED_BAND_SIZE - 1);
+    if (IsReady(Base + Offset))
+    {
+      break;
+    }
+  }
+  LastInBand[Band] = Offset;
+  return Base + Offset;
+
+#elif ES_SCHED_POLICY == ES_SCHED_AGING
+  uint32_t  Now = _CP0_GET_COUNT();
+  uint32_t  Waiting;
+  uint32_t  Effective;
+  uint32_t  BestEffective = 0;
+  bool      IsFirst = true;
+  uint8_t   Band = 0;
+  uint8_t   Base;
+  uint8_t   Offset;
+  uint8_t   Word;
+  uint8_t   i;
+
+  // find the highest effective priority. Ties between bands go to the
+  // higher band, since it is looked at first
+  for (Word = READY_WORDS; Word-- > 0;)
+  {
+    Waiting = ReadyWords[Word];
+    while (Waiting != 0)
+    {
+      i         = (uint8_t)((Word << 5) + ES_MSBitOfNonZero(Waiting));
+      Waiting  &= ~ReadyBitOf(i);
+      Effective = AgedPriority(i, Now);
+      if (IsFirst || (Effective > BestEffective))
+      {
+        IsFirst       = false;
+        BestEffective = Effective;
+        Band          = i / ES_SCHED_BAND_SIZE;
+      }
+    }
+  }
+  // the services in that band at that priority take turns, the next one
+  // down from the last to run
+  Base = Band * ES_SCHED_BAND_SIZE;
+  for (i = 1; i <= ES_SCHED_BAND_SIZE; i++)
+  {
+    Offset = (LastInBand[Band] - i) & (ES_SCHED_BAND_SIZE - 1);
+    if (IsReady(Base + Offset) &&
+        (AgedPriority(Base + Offset, Now) == BestEffective))
+    {
+      break;
+    }
+  }
+  LastInBand[Band] = Offset;
+  return Base + Offset;
+
+#else
+#error "ES_SCHED_POLICY must be one of the ES_SCHED_ values"
+#endif
+}
+
+/****************************************************************************
+ Function
+   NoteWait
+ Parameters
+   uint8_t : Which service ES_Run is about to run
+ Returns
+   nothing
+ Description
+   updates the worst case wait for the service
+ Author
+   M. Saboo, 10/16/26, 14:00
+****************************************************************************/
+static inline void NoteWait(uint8_t WhichService)
+{
+  uint32_t Waited = _CP0_GET_COUNT() - ReadySince[WhichService];
+
+  if (Waited > MaxWait[WhichService])
+  {
+    MaxWait[WhichService] = Waited;
+  }
+}
+
+#if ES_SCHED_POLICY == ES_SCHED_AGING
+/****************************************************************************
+ Function
+   AgedPriority
+ Parameters
+   uint8_t : a Ready service
+   uint32_t : the core timer count now
+ Returns
+   uint32_t : the service's effective priority
+ Description
+   the service's band, plus a level for each 2^ES_SCHED_AGING_SHIFT counts
+   that it has been Ready
+ Author
+   M. Saboo, 10/17/26, 10:50
+****************************************************************************/
+static inline uint32_t AgedPriority(uint8_t WhichService, uint32_t Now)
+{
+  uint32_t Age = (Now - ReadySince[WhichService]) >> ES_SCHED_AGING_SHIFT;
+
+  return (WhichService / ES_SCHED_BAND_SIZE) +
+         ((Age < MAX_NUM_SERVICES) ? Age : MAX_NUM_SERVICES);
+}
+#endif
+
+/****************************************************************************
+ Function
+   EnQueueFast
+ Parameters
+   ES_Event_t * pSlots : the entries of a service queue
+   ES_QueueIndex_t * pIndex : the indices for that queue
+   uint8_t Mask : number of entries - 1
+   ES_Event_t Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the add was successful, false if not
+ Description
+   adds Event2Add to the end of a service queue if there is room
+ Notes
+   Writes the entry before publishing the new PutIndex, so ES_Run never
+   sees the index move before the data is there. Only safe for one poster
+   at a time, PostFromTask provides that for multiple posters.
+ Author
+   M. Saboo, 10/16/26, 11:20
+****************************************************************************/
+static inline bool EnQueueFast(ES_Event_t *pSlots, ES_QueueIndex_t *pIndex,
+    uint8_t Mask, ES_Event_t Event2Add)
+{
+  uint8_t Put = pIndex->PutIndex;
+  uint8_t Get = __atomic_load_n(&pIndex->GetIndex, __ATOMIC_ACQUIRE);
+
+  if ((uint8_t)(Put - Get) > Mask) // already holds Mask + 1 entries
+  {
+    return false;
+  }
+  pSlots[Put & Mask] = Event2Add;
+  __atomic_store_n(&pIndex->PutIndex, (uint8_t)(Put + 1), __ATOMIC_RELEASE);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   DeQueueFast
+ Parameters
+   ES_Event_t * pSlots : the entries of a service queue
+   ES_QueueIndex_t * pIndex : the indices for that queue
+   uint8_t Mask : number of entries - 1
+   ES_Event_t * pReturnEvent : used to return the event pulled from the queue
+ Returns
+   The number of entries remaining in the Queue
+ Description
+   pulls the next entry from a service queue, ES_NO_EVENT if it was empty
+ Notes
+   Only called from ES_Run, through the DeQueueN functions generated by
+   ES_SERVICE_QUEUE, so that Mask is a constant.
+ Author
+   M. Saboo, 10/16/26, 11:20
+****************************************************************************/
+static inline uint8_t DeQueueFast(ES_Event_t *pSlots, ES_QueueIndex_t *pIndex,
+    uint8_t Mask, ES_Event_t *pReturnEvent)
+{
+  uint8_t Get = pIndex->GetIndex;
+  uint8_t Put = __atomic_load_n(&pIndex->PutIndex, __ATOMIC_ACQUIRE);
+
+  if (Put == Get)   // no items left in the queue
+  {
+    (*pReturnEvent).EventType   = ES_NO_EVENT;
+    (*pReturnEvent).EventParam  = 0;
+    return 0;
+  }
+  *pReturnEvent = pSlots[Get & Mask];
+  Get++;
+  __atomic_store_n(&pIndex->GetIndex, Get, __ATOMIC_RELEASE);
+  return (uint8_t)(Put - Get);
+}
+
+/****************************************************************************
+ Function
+   MarkQueueEmpty
+ Parameters
+   uint8_t : Which service's queue was just emptied
+ Returns
+   nothing
+ Description
+   clears the Ready bit for the service
+ Notes
+   an ISR may have posted between the DeQueue and the clear, so look again
+   rather than strand its event until the next post
+ Author
+   M. Saboo, 10/16/26, 11:20
+****************************************************************************/
+static inline void MarkQueueEmpty(uint8_t WhichService)
+{
+  ES_QueueIndex_t *pIndex = EventQueues[WhichService].pIndex;
+
+  ClrReady(WhichService);
+  if (__atomic_load_n(&pIndex->PutIndex, __ATOMIC_ACQUIRE) !=
+      pIndex->GetIndex)
+  {
+    SetReady(WhichService);
+  }
+}
+
+/****************************************************************************
+ Function
+   PostFromTask
+ Parameters
+   uint8_t : Which service to post to (index into EventQueues)
+   ES_Event : The Event to be posted
+ Returns
+   boolean : False if the queue was full
+ Description
+   posts to a service's queue and marks it as Ready. Coalescing events
+   may be merged into one already waiting in the queue instead.
+ Notes
+   Posters in the ES_Run context and ISRs posting to ES_QUEUE_LOCKED queues
+   may interrupt one another, so the post is made with ints off.
+ Author
+   M. Saboo, 10/16/26, 11:20
+****************************************************************************/
+static bool PostFromTask(uint8_t WhichService, ES_Event_t TheEvent)
+{
+  ES_QueueDesc_t const  *pQueue = &EventQueues[WhichService];
+  bool                  ReturnVal;
+
+  EnterCritical();
+  if (CoalesceQueued(pQueue, TheEvent) == true)
+  {
+    ExitCritical();
+    return true;  // queue was already Ready
+  }
+  ReturnVal = EnQueueFast(pQueue->pSlots, pQueue->pIndex, pQueue->Mask,
+      TheEvent);
+  if (ReturnVal == true)
+  {
+    ES_PROFILE_POST(WhichService,
+        (uint8_t)(pQueue->pIndex->PutIndex - pQueue->pIndex->GetIndex));
+  }
+  else
+  {
+    ES_PROFILE_POST_FAILED(WhichService);
+  }
+  ExitCritical();
+  if (ReturnVal == true)
+  {
+    SetReady(WhichService); // show queue as non-empty
+  }
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   CoalesceQueued
+ Parameters
+   ES_QueueDesc_t const * : the queue being posted to
+   ES_Event : The Event being posted
+ Returns
+   boolean : true if the event was merged into one already in the queue
+ Description
+   if TheEvent is one of the ES_COALESCING_EVENTS and an event of the same
+   type is waiting in the queue, replaces the parameter of the waiting
+   event with the new one
+ Notes
+   must be called with ints off, since it may write to any queued entry.
+   The lock-free ISR post to an ES_QUEUE_SPSC queue cannot do that, so
+   those posts are never coalesced.
+   The entry at GetIndex is left alone: DeQueueFast copies it out before it
+   publishes the new GetIndex, without a lock, so an ISR that coalesced
+   into it could have its parameter lost after ES_Run had taken the copy.
+ Author
+   M. Saboo, 10/16/26, 13:05
+****************************************************************************/
+static bool CoalesceQueued(ES_QueueDesc_t const *pQueue, ES_Event_t TheEvent)
+{
+#ifdef ES_COALESCING_EVENTS
+  uint8_t i;
+  uint8_t Index;
+
+  for (i = 0; i < ARRAY_SIZE(CoalescingEvents); i++)
+  {
+    if (CoalescingEvents[i] == TheEvent.EventType)
+    {
+      // a coalescing type, so look for one waiting in the queue behind
+      // the head (if the queue is empty there is no head to skip)
+      Index = pQueue->pIndex->GetIndex;
+      if (Index == pQueue->pIndex->PutIndex)
+      {
+        break;
+      }
+      for (Index++; Index != pQueue->pIndex->PutIndex; Index++)
+      {
+        if (pQueue->pSlots[Index & pQueue->Mask].EventType ==
+            TheEvent.EventType)
+        {
+          pQueue->pSlots[Index & pQueue->Mask].EventParam =
+              TheEvent.EventParam;
+          return true;
+        }
+      }
+      break;
+    }
+  }
+#endif
+  return false;
+}
+
+#ifdef ES_TICKLESS
+/****************************************************************************
+ Function
+   IdleUntilNeeded
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   stops the tick and puts the CPU in WAIT until the next timer expires,
+   the next event checker with a poll period is due, ES_TICKLESS_MAX_TICKS
+   have passed or an interrupt wakes it
+ Notes
+   called from ES_Run once the queues are empty and the event checkers
+   found nothing. Ready and the checker wake flags are tested again with
+   ints off, so that an event posted or a checker woken by an ISR after the
+   checkers ran keeps us awake. The sleep is skipped while the terminal
+   has bytes to send, since the UART is polled
+ Author
+   M. Saboo, 10/16/26, 23:00
+****************************************************************************/
+static void IdleUntilNeeded(void)
+{
+  uint32_t MaxTicks;
+  uint32_t CheckerTicks;
+
+  if (!Terminal_IsTxEmpty())
+  {
+    return;
+  }
+  MaxTicks      = ES_Timer_TicksToNextExpiry();
+  CheckerTicks  = ES_CheckerTicksToNextDue();
+  if (CheckerTicks < MaxTicks)
+  {
+    MaxTicks = CheckerTicks;
+  }
+  if (MaxTicks > ES_TICKLESS_MAX_TICKS)
+  {
+    MaxTicks = ES_TICKLESS_MAX_TICKS;
+  }
+  EnterCritical();
+  if ((ReadyGroups == 0) && !ES_AreCheckersWoken())
+  {
+    _HW_IdleWait(MaxTicks); // returns with ints enabled
+  }
+  else
+  {
+    ExitCritical();
+  }
+}
+
+#endif
 #if 0
 /****************************************************************************
  Function
@@ -472,6 +1255,87 @@ static bool CheckSystemEvents(void)
   return false;
 }
 
+#endif
+
+#ifdef LATENCY_BENCH
+/* Worst case interrupt latency while posting from an ISR.
+   Timer2 interrupts at IPL7 every BENCH_PERIOD peripheral clocks and posts
+   to service 0 with ES_PostToServiceFromISR, while the main loop takes the
+   events out of its queue as fast as it can, the same way that ES_Run
+   does. TMR2 is cleared by the period match, so the value read at the top
+   of the ISR is the latency in 50nS counts. Any time that the main loop
+   spends with interrupts off shows up in the maximum.
+   Build once with SERV_0_QUEUE_KIND set to each kind to compare them.
+   Build with the rest of the framework and PIC32_PORT_HAL, but without
+   main.c */
+#include <sys/attribs.h>
+#include "terminal.h"
+
+#define BENCH_PERIOD 400      // 20uS at 20MHz
+#define BENCH_SAMPLES 50000
+
+static volatile uint16_t  MaxLatency;
+static volatile uint32_t  NumSamples;
+static volatile uint32_t  NumDropped;
+
+void main(void)
+{
+  ES_Event_t ThisEvent;
+
+  _HW_PIC32Init();
+  puts("\rES_PostToServiceFromISR latency benchmark\r");
+
+  T2CONbits.ON    = 0;
+  T2CONbits.TCS   = 0;  // PBCLK
+  T2CONbits.T32   = 0;
+  T2CONbits.TCKPS = 0;  // 1:1
+  PR2             = BENCH_PERIOD - 1;
+  IPC2bits.T2IP   = 7;  // above everything else, including the SysTick
+  IFS0CLR         = _IFS0_T2IF_MASK;
+  IEC0SET         = _IEC0_T2IE_MASK;
+
+  TMR2          = 0;
+  T2CONbits.ON  = 1;
+  while (NumSamples < BENCH_SAMPLES)
+  {
+    // the same consumer sequence as ES_Run
+    if (IsReady(0))
+    {
+      if (DeQueue0(&ThisEvent) == 0)
+      {
+        MarkQueueEmpty(0);
+      }
+    }
+  }
+  T2CONbits.ON = 0;
+  printf("%s: max latency %u counts\r\n",
+      (EventQueues[0].Kind == ES_QUEUE_SPSC) ? "SPSC" : "LOCKED", MaxLatency);
+  printf("%lu posts, %lu dropped\r\n", (unsigned long)NumSamples,
+      (unsigned long)NumDropped);
+  while (1)
+  {
+    Terminal_MoveBuffer2UART(); // printf only fills the transmit buffer
+  }
+}
+
+void __ISR(_TIMER_2_VECTOR, IPL7SOFT) BenchTimer2ISR(void)
+{
+  uint16_t    Latency = TMR2;
+  ES_Event_t  BenchEvent;
+
+  IFS0CLR = _IFS0_T2IF_MASK;
+  if (Latency > MaxLatency)
+  {
+    MaxLatency = Latency;
+  }
+  BenchEvent.EventType  = ES_NO_EVENT;
+  BenchEvent.EventParam = Latency;
+  if (ES_PostToServiceFromISR(0, BenchEvent) != true)
+  {
+    NumDropped++;
+  }
+  NumSamples++;
+}
 #endif
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
@@ -1,4 +1,5 @@
 //#define TEST
+//#define LOOKUP_BENCH
 /****************************************************************************
  Module
      ES_LookupTables.c
@@ -18,6 +19,10 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/16/26 15:00 mss      ES_GetMSBitSet now uses the clz instruction when the
+                         compiler offers it, the nybble walk is kept as the
+                         portable fallback. Added ES_GetMSBitSet32 and the
+                         LOOKUP_BENCH comparison of the two
  10/20/13 17:03 jec      converted Byte2MSBitNum array to a Nybble sized array
                          (15 entries) and made function GetMSBitSet() to figure
                          out the MSB set. This was done to facilitate moving to
@@ -33,12 +38,14 @@
 #include "ES_Types.h"
 #include "ES_General.h"
 #include "ES_Timers.h"
+#include "ES_LookupTables.h"
 #include "bitdefs.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define ISOLATE_LS_NYBBLE 0x0F
 
 /*---------------------------- Module Functions ---------------------------*/
+static uint8_t MSBitByNybble(uint32_t Val2Check, int8_t NumNybbles);
 
 /*---------------------------- Module Variables ---------------------------*/
 
@@ -77,14 +84,49 @@ uint8_t const Nybble2MSBitNum[15] = {
 
 /*------------------------------ Module Code ------------------------------*/
 uint8_t ES_GetMSBitSet(uint16_t Val2Check)
+{
+  if (Val2Check == 0)
+  {
+    return 128; // this is the error return value
+  }
+#ifdef __GNUC__
+  return ES_MSBitOfNonZero(Val2Check);
+#else
+  return MSBitByNybble(Val2Check,
+             sizeof(Val2Check) * (BITS_PER_BYTE / BITS_PER_NYBBLE));
+#endif
+}
+
+uint8_t ES_GetMSBitSet32(uint32_t Val2Check)
+{
+  return MSBitByNybble(Val2Check,
+             sizeof(Val2Check) * (BITS_PER_BYTE / BITS_PER_NYBBLE));
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   MSBitByNybble
+ Parameters
+   uint32_t  Val2Check The number to find the MSB in
+   int8_t NumNybbles how many nybbles of Val2Check to look at
+ Returns
+   bit number of the MSB that is set in Val2Check, 128 if Val2Check = 0
+ Description
+   the original ES_GetMSBitSet, walks down the nybbles using Nybble2MSBitNum
+ Author
+   J. Edward Carryer, 10/20/13, 17:03
+****************************************************************************/
+static uint8_t MSBitByNybble(uint32_t Val2Check, int8_t NumNybbles)
 {
   int8_t  LoopCntr;
   uint8_t Nybble2Test;
   uint8_t ReturnVal = 128; // this is the error return value
 
   // loop through the parameter, nybble by nybble
-  for (LoopCntr = sizeof(Val2Check) * (BITS_PER_BYTE / BITS_PER_NYBBLE) - 1;
-      LoopCntr >= 0; LoopCntr--)
+  for (LoopCntr = NumNybbles - 1; LoopCntr >= 0; LoopCntr--)
   {
     // move a nybble into the 4 LSB positions for lookup
     Nybble2Test = (uint8_t)
@@ -101,9 +143,6 @@ uint8_t ES_GetMSBitSet(uint16_t Val2Check)
   return ReturnVal;
 }
 
-/***************************************************************************
- private functions
- ***************************************************************************/
 #ifdef TEST
 #include <stdio.h>
 
@@ -125,5 +164,55 @@ void main(void)
   }
 }
 
+#endif
+
+#ifdef LOOKUP_BENCH
+/* Compares the cost of the nybble walk with the clz version over every
+   16 bit Ready value. Times are in core timer counts (2 SYSCLKs on the
+   PIC32, 50nS on the host port) per 65535 lookups. Build with ES_Port.c
+   and terminal.c for the console. */
+#include <stdio.h>
+#include "ES_Port.h"
+#include "terminal.h"
+
+void main(void)
+{
+  uint32_t          Counter;
+  uint32_t          StartTime;
+  uint32_t          NybbleTime;
+  uint32_t          ClzTime;
+  volatile uint8_t  MSBit;  // keep the optimizer from dropping the lookups
+
+  _HW_PIC32Init();
+  puts("\rMSB lookup benchmark\r");
+  for (Counter = 1; Counter <= 0xFFFF; Counter++)
+  {
+    if (MSBitByNybble(Counter, 4) != ES_GetMSBitSet(Counter))
+    {
+      printf("mismatch at %lu\r\n", (unsigned long)Counter);
+    }
+  }
+
+  StartTime = _CP0_GET_COUNT();
+  for (Counter = 1; Counter <= 0xFFFF; Counter++)
+  {
+    MSBit = MSBitByNybble(Counter, 4);
+  }
+  NybbleTime = _CP0_GET_COUNT() - StartTime;
+
+  StartTime = _CP0_GET_COUNT();
+  for (Counter = 1; Counter <= 0xFFFF; Counter++)
+  {
+    MSBit = ES_MSBitOfNonZero(Counter);
+  }
+  ClzTime = _CP0_GET_COUNT() - StartTime;
+
+  printf("nybble walk: %lu counts\r\n", (unsigned long)NybbleTime);
+  printf("clz        : %lu counts\r\n", (unsigned long)ClzTime);
+  while (1)
+  {
+    Terminal_MoveBuffer2UART(); // printf only fills the transmit buffer
+  }
+}
 #endif
 /*------------------------------ End of File ------------------------------*/
@@ -13,6 +13,19 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 11:30 mss     _HW_IdleWait returns at once with the tick off or
+                        MaxTicks of 0, as on the host port
+ 10/17/26 11:20 mss     keeps the core count of the last tick credited, for
+                        _HW_GetLastTickCount
+ 10/17/26 11:00 mss     keeps the ticks slept through in TicksSlept and passes
+                        them to ES_TIMER_STATS_SLEPT, so that the timer stats
+                        do not count a sleep as a catch-up
+ 10/17/26 03:00 mss     added the ES_TIMER_STATS_CATCH_UP hook
+ 10/17/26 00:00 mss     _HW_Process_Pending_Ints catches up all of the pending
+                        ticks with one call to ES_Timer_Advance
+ 10/16/26 23:00 mss     added _HW_IdleWait for ES_TICKLESS, TickCount and the
+                        catch-up count are now 32 bits so that a long sleep
+                        (or a long stall) can not wrap them
  08/06/21 15:43 jec     no changes just a test of using GIT from within MPLABX
  08/06/21 13:04 jec     cleaned things up in preparation for the 2021 AY
  10/05/20 18:52 ram     started work on port to PIC32MX170F256B
@@ -73,6 +86,7 @@
 #include "ES_Port.h"        // the header file for this module
 #include "ES_Types.h"       // framework type definitions
 #include "ES_Timers.h"      // framework timer prototypes
+#include "ES_TimerStats.h"  // for the catch-up statistics hook
 
 #include "terminal.h"       // terminal prototypes for init function
 
@@ -83,7 +97,7 @@
 // need to post events from the interrupt response routine. This is necessary
 // for compilers like HTC for the midrange PICs which do not produce re-entrant
 // code so cannot post directly to the queues from within the interrupt resp.
-static volatile uint8_t TickCount;
+static volatile uint32_t TickCount;
 
 // Global tick count to monitor number of SysTick Interrupts
 // make uint16_t to maintain backwards compatibility and not overly burden
@@ -94,6 +108,19 @@ static volatile uint16_t SysTickCounter = 0;
 // ensure the interrupts occur periodically
 static volatile TimerRate_t tickPeriod; 
 
+// Ticks that _HW_IdleWait skipped by moving the compare out past them. The
+// tick ISR credits them along with the tick that ends the sleep
+static volatile uint32_t TicksSkipped;
+
+// how many of TickCount passed while _HW_IdleWait had us asleep, for the
+// timer statistics
+static volatile uint32_t TicksSlept;
+
+// the core count that the last tick credited to TickCount was due at, and
+// its value when the ticks were last handed to ES_Timer_Advance
+static volatile uint32_t LastTickCount;
+static uint32_t AdvancedTickCount;
+
 // This variable is used to store the state of the interrupt mask when
 // doing EnterCritical/ExitCritical pairs
 // uint8_t _INTCON_temp;
@@ -104,6 +131,10 @@ static volatile TimerRate_t tickPeriod;
  ***************************************************************************/
 
 //#define LED_DEBUG
+
+// core timer counts needed to re-program the compare before it is reached,
+// with room to spare (see the -12 in _HW_SysTickIntHandler)
+#define IDLE_MARGIN 100
 /****************************************************************************
  Function
     _HW_PIC32Init
@@ -203,7 +234,7 @@ void _HW_Timer_Init(const TimerRate_t Rate)
 void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO ) _HW_SysTickIntHandler(void)
 {
   static uint32_t deltaTime; // static for speed
-  static uint8_t intsThatShouldHaveHappened;
+  static uint32_t intsThatShouldHaveHappened;
   
   // clear interrupt flag using the atomic write to the CLR version of the
   // interrupt flag register
@@ -215,6 +246,8 @@ void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO ) _HW_SysTickIntHandler(void)
   // compare for a time that had already passed, resulting in a loss of 
   // tick interrupts until the CoreTimer rolled around.
   EnterCritical();
+  // the tick that is due now, before the compare moves on from it
+  LastTickCount = _CP0_GET_COMPARE();
   // get the time difference since the interrupt
   deltaTime = _CP0_GET_COUNT() - _CP0_GET_COMPARE();
   
@@ -252,7 +285,13 @@ void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO ) _HW_SysTickIntHandler(void)
     // now update the compare register
     _CP0_SET_COMPARE(_CP0_GET_COMPARE() + 
       (intsThatShouldHaveHappened * tickPeriod));
+    LastTickCount += (intsThatShouldHaveHappened - 1) * tickPeriod;
+    ES_TIMER_STATS_CATCH_UP(intsThatShouldHaveHappened);
   }// end if (deltaTime < tickPeriod - 12)
+  // plus any that _HW_IdleWait had us sleep through
+  intsThatShouldHaveHappened += TicksSkipped;
+  TicksSlept += TicksSkipped;
+  TicksSkipped = 0;
   ExitCritical();
   // and keep our tick counters going
   TickCount += intsThatShouldHaveHappened;
@@ -264,6 +303,93 @@ void __ISR(_CORE_TIMER_VECTOR, IPL3AUTO ) _HW_SysTickIntHandler(void)
 #endif
 }
 
+/****************************************************************************
+ Function
+     _HW_IdleWait
+ Parameters
+     uint32_t MaxTicks, the most ticks to sleep for (the tick that the next
+     timer expires on)
+ Returns
+     None.
+ Description
+     moves the compare out to the last of the next MaxTicks ticks, so that
+     the tick interrupts in between do not happen, and WAITs for any
+     interrupt. If the compare ends the WAIT, the tick ISR credits the
+     skipped ticks. If something else does, the ticks that have passed are
+     credited here and the compare goes back to the next tick.
+ Notes
+     Called from ES_Run with ints disabled, returns with them enabled.
+     Keeping ints off up to the WAIT means that an ISR can not post an event
+     after ES_Run looked at the queues and leave us asleep with an event
+     waiting. A pending interrupt still ends the WAIT with ints disabled
+     (PIC32 FRM sec. 10), and its ISR runs when they are enabled again.
+     MaxTicks is limited so that the compare stays within half of the
+     Count's range.
+ Author
+     M. Saboo, 10/16/26, 23:00
+****************************************************************************/
+void _HW_IdleWait(uint32_t MaxTicks)
+{
+  uint32_t NextTick = _CP0_GET_COMPARE();
+  uint32_t LastTick;
+  uint32_t Now;
+  uint32_t Passed;
+
+  // with a tick pending or due in the next few instructions the timers
+  // are not up to date, so don't stretch the compare. With the tick off
+  // there is nothing to wake us, and MaxTicks of 0 means a checker is due
+  if ((TickCount != 0) || (tickPeriod == 0) || (MaxTicks == 0) ||
+      IFS0bits.CTIF ||
+      ((int32_t)(NextTick - _CP0_GET_COUNT()) < IDLE_MARGIN))
+  {
+    ExitCritical();
+    return;
+  }
+  if (MaxTicks > (INT32_MAX / tickPeriod))
+  {
+    MaxTicks = INT32_MAX / tickPeriod;
+  }
+  if (MaxTicks > 1)
+  {
+    TicksSkipped = MaxTicks - 1;
+    LastTick = NextTick + (TicksSkipped * tickPeriod);
+    _CP0_SET_COMPARE(LastTick);
+  }
+  else
+  {
+    LastTick = NextTick;
+  }
+
+  _wait();
+
+  Now = _CP0_GET_COUNT();
+  // unless the compare woke us, or is about to, take the ticks that have
+  // passed and put the compare back on the tick after them
+  if ((TicksSkipped != 0) && !IFS0bits.CTIF &&
+      ((int32_t)(LastTick - Now) >= IDLE_MARGIN))
+  {
+    Passed = ((int32_t)(Now - NextTick) < 0) ? 0 :
+        ((Now - NextTick) / tickPeriod) + 1;
+    NextTick += Passed * tickPeriod;
+    if ((int32_t)(NextTick - Now) < IDLE_MARGIN)
+    {
+      // too close to program, credit it a few counts early instead
+      Passed++;
+      NextTick += tickPeriod;
+    }
+    _CP0_SET_COMPARE(NextTick);
+    if (Passed != 0)
+    {
+      LastTickCount = NextTick - tickPeriod;
+    }
+    TicksSkipped    = 0;
+    TicksSlept     += Passed;
+    TickCount      += Passed;
+    SysTickCounter += Passed;
+  }
+  ExitCritical();
+}
+
 /****************************************************************************
  Function
     _HW_GetTickCount()
@@ -284,6 +410,28 @@ uint16_t _HW_GetTickCount(void)
   return SysTickCounter;
 }
 
+/****************************************************************************
+ Function
+    _HW_GetLastTickCount()
+ Parameters
+    none
+ Returns
+    uint32_t  the core count that the last of the ticks handed to
+    ES_Timer_Advance was due at
+ Description
+    lets the timer statistics time an expiry from its deadline, however
+    late _HW_Process_Pending_Ints got to the tick
+ Notes
+    A tick credited a few counts early, at the end of a catch-up or a
+    sleep, reads as due at the count it was credited for
+ Author
+    M. Saboo, 10/17/26, 11:20
+****************************************************************************/
+uint32_t _HW_GetLastTickCount(void)
+{
+  return AdvancedTickCount;
+}
+
 /****************************************************************************
  Function
      _HW_Process_Pending_Ints
@@ -307,13 +455,23 @@ uint16_t _HW_GetTickCount(void)
 ****************************************************************************/
 bool _HW_Process_Pending_Ints(void)
 {
+  static uint32_t Ticks; // static for speed
+
   // in the case where there was a long delay in getting to this function,
-  // multiple interrupts may have occurred (TickCount > 1), so process them all
-  while (TickCount > 0)
+  // multiple interrupts may have occurred (TickCount > 1). Take them all at
+  // once, so that a tick that arrives meanwhile is not lost, and have the
+  // timers catch up in a single pass
+  EnterCritical();
+  Ticks     = TickCount;
+  TickCount = 0;
+  ES_TIMER_STATS_SLEPT(TicksSlept);
+  TicksSlept = 0;
+  AdvancedTickCount = LastTickCount;
+  ExitCritical();
+  if (Ticks != 0)
   {
     /* call the framework tick response to actually run the timers */
-    ES_Timer_Tick_Resp();
-    TickCount--;
+    ES_Timer_Advance(Ticks);
   }
   return true;  // always return true to allow loop test in ES_Run to proceed
 }
@@ -0,0 +1,373 @@
+/****************************************************************************
+ Module
+   ES_Port_Host.c
+
+ Revision
+   1.0.1
+
+ Description
+   This is the Linux host port of the hardware specific functions for the
+   Events & Services Framework. It lets ES_Framework.c, ES_Queue.c and
+   ES_Timers.c run (and be profiled with perf) at native speed on a PC.
+ Notes
+   Build every framework source with -DES_HOST_PORT and link this module,
+   terminal_Host.c and ES_ShortTimer_Host.c in place of ES_Port.c,
+   terminal.c and ES_ShortTimer.c, e.g.:
+     gcc -DES_HOST_PORT -IFrameworkHeaders -IProjectHeaders
+         FrameworkSource/ES_Framework.c FrameworkSource/ES_Queue.c ...
+         FrameworkSource/ES_Port_Host.c FrameworkSource/terminal_Host.c
+         FrameworkSource/ES_ShortTimer_Host.c
+   along with the services to be run. Leave out ES_Port.c, terminal.c,
+   ES_ShortTimer.c and the PIC32 hardware modules.
+   The tick emulates the PIC32 core timer: _HW_GetCoreCount is a 20MHz
+   count taken from CLOCK_MONOTONIC and a software Compare value stands in
+   for the CP0 Compare register. The tick is polled from
+   _HW_Process_Pending_Ints, at exactly the point in ES_Run where the PIC32
+   port processes TickCount. clock_gettime() is serviced by the vDSO, so
+   the poll costs no system call (a timerfd or signal tick would cost one
+   per dispatch and skew the profiles). Since nothing runs asynchronously,
+   EnterCritical/ExitCritical compile to nothing on this port.
+   The TimerRate_t values are core timer counts at 20MHz, the host port
+   keeps that meaning so ES_Timer_RATE_1mS is still a 1mS tick.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 11:50 mss     function headers credit the host port code to its
+                        author, noting what was derived from ES_Port.c
+ 10/17/26 11:20 mss     added _HW_GetLastTickCount, as on the PIC32
+ 10/17/26 11:10 mss     polls the terminal for a key once a tick
+ 10/17/26 11:00 mss     _HW_IdleWait credits the ticks it slept through
+                        itself and passes them to ES_TIMER_STATS_SLEPT, as
+                        on the PIC32
+ 10/17/26 03:00 mss     added the ES_TIMER_STATS_CATCH_UP hook
+ 10/17/26 02:00 mss     polls the short timers along with the tick
+ 10/17/26 00:00 mss     _HW_Process_Pending_Ints catches up all of the pending
+                        ticks with one call to ES_Timer_Advance
+ 10/16/26 23:00 mss     added _HW_IdleWait for ES_TICKLESS, TickCount is now
+                        32 bits as on the PIC32
+ 10/16/26 09:12 mss     first pass, derived from the PIC32 ES_Port.c
+ ***************************************************************************/
+#define _GNU_SOURCE
+
+#include <stdint.h>         // for exact size data types
+#include <stdbool.h>        // for the bool data type
+#include <stdio.h>
+#include <time.h>           // for clock_gettime()
+#include <poll.h>           // for the sleep in _HW_IdleWait
+#include <unistd.h>         // for STDIN_FILENO
+
+#include "ES_Port.h"        // the header file for this module
+#include "ES_Types.h"       // framework type definitions
+#include "ES_Timers.h"      // framework timer prototypes
+#include "ES_ShortTimer.h"  // for ES_ShortTimer_HostPoll
+#include "ES_TimerStats.h"  // for the catch-up statistics hook
+
+#include "terminal.h"       // terminal prototypes for init function
+
+/****************************************************************************
+ * Module Level defines
+ ***************************************************************************/
+// the simulated core timer runs at 20MHz, 50nS per count
+#define NS_PER_CORE_COUNT 50
+#define NS_PER_SEC 1000000000L
+#define CORE_COUNTS_PER_MS 20000
+
+// TickCount is used to track the number of timer ints that have occurred
+// since the last check. See the notes in ES_Port.c
+static uint32_t TickCount;
+
+// Global tick count to monitor number of SysTick Interrupts
+// make uint16_t to maintain backwards compatibility with the PIC32 port
+static uint16_t SysTickCounter = 0;
+
+// Rate value that needs to be continually added to the compare value to
+// ensure the ticks occur periodically, 0 when the tick is off
+static TimerRate_t tickPeriod;
+
+// software stand-in for the CP0 Compare register
+static uint32_t CoreCompare;
+
+// how many of TickCount passed while _HW_IdleWait had us asleep, for the
+// timer statistics
+static uint32_t TicksSlept;
+
+// the core count that the last tick credited to TickCount was due at, and
+// its value when the ticks were last handed to ES_Timer_Advance
+static uint32_t LastTickCount;
+static uint32_t AdvancedTickCount;
+
+// set while _HW_IdleWait credits the ticks that it slept through
+static bool IsWaking;
+
+/****************************************************************************
+ Function
+    _HW_PIC32Init
+ Parameters
+    none
+ Returns
+     None.
+ Description
+    Initializes the basic hardware. On the host that is only the terminal
+ Notes
+    keeps the PIC32 name so that main.c runs unchanged on the host.
+    Derived from _HW_PIC32Init in ES_Port.c
+ Author
+     M. Saboo, 10/16/26 09:12
+****************************************************************************/
+void _HW_PIC32Init(void)
+{
+  Terminal_HWInit();
+}
+
+/****************************************************************************
+ Function
+     _HW_Timer_Init
+ Parameters
+     TimerRate_t Rate set to one of the TMR_RATE_XX enum values to set the
+     Tick rate
+ Returns
+     None.
+ Description
+     Programs the first compare value to generate the SysTicks
+ Notes
+     Rate is in 20MHz core timer counts, the same as on the PIC32.
+     Derived from _HW_Timer_Init in ES_Port.c
+ Author
+    M. Saboo, 10/16/26 09:12
+****************************************************************************/
+void _HW_Timer_Init(const TimerRate_t Rate)
+{
+  // If a non-zero rate has been selected
+  if (Rate > 0)
+  {
+    // copy over rate value to module var
+    tickPeriod = Rate;
+    // place the first tick time into the compare value
+    CoreCompare = _HW_GetCoreCount() + Rate;
+  }
+  return;
+}
+
+/****************************************************************************
+ Function
+     _HW_SysTickIntHandler
+ Parameters
+     none
+ Returns
+     None.
+ Description
+     stand-in for the core timer interrupt response. Credits every tick
+     period that has elapsed since the last call and re-programs the
+     compare value.
+ Notes
+     a long delay in getting here shows up as more than 1 tick, just like
+     the catch-up branch of the PIC32 ISR. Polled rather than an interrupt,
+     derived from the core timer ISR in ES_Port.c
+ Author
+    M. Saboo, 10/16/26 09:12
+****************************************************************************/
+void _HW_SysTickIntHandler(void)
+{
+  uint32_t deltaTime;
+  uint32_t intsThatShouldHaveHappened;
+
+  // the signed test handles the wrap of the count, just as the hardware
+  // compare does
+  if ((tickPeriod != 0) &&
+      ((int32_t)(_HW_GetCoreCount() - CoreCompare) >= 0))
+  {
+    deltaTime = _HW_GetCoreCount() - CoreCompare;
+    // 1 for the compare that just passed plus any whole periods after it
+    intsThatShouldHaveHappened = (deltaTime / tickPeriod) + 1;
+    LastTickCount = CoreCompare +
+        ((intsThatShouldHaveHappened - 1) * tickPeriod);
+    CoreCompare += intsThatShouldHaveHappened * tickPeriod;
+    if (IsWaking)
+    {
+      TicksSlept += intsThatShouldHaveHappened;
+    }
+    else if (intsThatShouldHaveHappened > 1)
+    {
+      ES_TIMER_STATS_CATCH_UP(intsThatShouldHaveHappened);
+    }
+    // and keep our tick counters going
+    TickCount       += intsThatShouldHaveHappened;
+    SysTickCounter  += (uint16_t)intsThatShouldHaveHappened;
+  }
+}
+
+/****************************************************************************
+ Function
+     _HW_IdleWait
+ Parameters
+     uint32_t MaxTicks, the most ticks to sleep for (the tick that the next
+     timer expires on)
+ Returns
+     None.
+ Description
+     sleeps until the last of the next MaxTicks ticks or until a key is
+     waiting on stdin, the stand-in for the UART receive interrupt waking
+     the PIC32
+ Notes
+     the ticks that passed are credited as soon as we wake, so that they
+     are counted as slept through rather than as a catch-up
+ Author
+     M. Saboo, 10/16/26, 23:00
+****************************************************************************/
+void _HW_IdleWait(uint32_t MaxTicks)
+{
+  struct pollfd StdinPoll = { STDIN_FILENO, POLLIN, 0 };
+  int32_t       CountsLeft;
+
+  // a running short timer is polled, so it needs us awake
+  if ((TickCount != 0) || (tickPeriod == 0) || (MaxTicks == 0) ||
+      ES_ShortTimerIsRunning(ES_SHORT_TIMER_A) ||
+      ES_ShortTimerIsRunning(ES_SHORT_TIMER_B))
+  {
+    return;
+  }
+  if (MaxTicks > (INT32_MAX / tickPeriod))
+  {
+    MaxTicks = INT32_MAX / tickPeriod;
+  }
+  CountsLeft = (int32_t)(CoreCompare + ((MaxTicks - 1) * tickPeriod) -
+      _HW_GetCoreCount());
+  if (CountsLeft > 0)
+  {
+    // round up, so that we wake after the tick rather than just before it
+    poll(&StdinPoll, 1,
+        (CountsLeft + CORE_COUNTS_PER_MS - 1) / CORE_COUNTS_PER_MS);
+    IsWaking = true;
+    _HW_SysTickIntHandler();
+    IsWaking = false;
+    // a key that ended the sleep wakes its checker now, as the receive
+    // interrupt would
+    Terminal_HostPoll();
+  }
+}
+
+/****************************************************************************
+ Function
+    _HW_GetTickCount()
+ Parameters
+    none
+ Returns
+    uint16_t   count of number of system ticks that have occurred.
+ Description
+    wrapper for access to SysTickCounter
+ Notes
+    polls the tick first, since there is no interrupt to keep it current
+    during blocking code. Derived from _HW_GetTickCount in ES_Port.c
+ Author
+    M. Saboo, 10/16/26 09:12
+****************************************************************************/
+uint16_t _HW_GetTickCount(void)
+{
+  _HW_SysTickIntHandler();
+  return SysTickCounter;
+}
+
+/****************************************************************************
+ Function
+    _HW_GetCoreCount()
+ Parameters
+    none
+ Returns
+    uint32_t  simulated value of the 20MHz CP0 Count register
+ Description
+    derived from CLOCK_MONOTONIC so that it wraps just like the real
+    register does (every 214.7 seconds)
+ Notes
+    _CP0_GET_COUNT() maps to this function on the host port
+ Author
+    M. Saboo, 10/16/26 09:12
+****************************************************************************/
+uint32_t _HW_GetCoreCount(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint32_t)(((uint64_t)Now.tv_sec * NS_PER_SEC + Now.tv_nsec) /
+         NS_PER_CORE_COUNT);
+}
+
+/****************************************************************************
+ Function
+    _HW_GetLastTickCount()
+ Parameters
+    none
+ Returns
+    uint32_t  the simulated core count that the last of the ticks handed
+    to ES_Timer_Advance was due at
+ Description
+    see ES_Port.c
+ Author
+    M. Saboo, 10/17/26, 11:20
+****************************************************************************/
+uint32_t _HW_GetLastTickCount(void)
+{
+  return AdvancedTickCount;
+}
+
+/****************************************************************************
+ Function
+     _HW_Process_Pending_Ints
+ Parameters
+     none
+ Returns
+     always true.
+ Description
+     polls the short timers and the tick timer, then advances the
+     framework timers by the ticks that have elapsed
+ Notes
+     see the notes in ES_Port.c on why this always returns true. Derived
+     from _HW_Process_Pending_Ints in ES_Port.c
+ Author
+     M. Saboo, 10/16/26 09:12
+****************************************************************************/
+bool _HW_Process_Pending_Ints(void)
+{
+  uint32_t Ticks;
+
+  ES_ShortTimer_HostPoll();
+  _HW_SysTickIntHandler();
+  // in the case where there was a long delay in getting to this function,
+  // multiple ticks may have occurred (TickCount > 1), so have the timers
+  // catch up on all of them in a single pass. Take them first, since a
+  // timer callback may poll the tick again through _HW_GetTickCount
+  Ticks     = TickCount;
+  TickCount = 0;
+  ES_TIMER_STATS_SLEPT(TicksSlept);
+  TicksSlept = 0;
+  AdvancedTickCount = LastTickCount;
+  if (Ticks != 0)
+  {
+    /* call the framework tick response to actually run the timers */
+    ES_Timer_Advance(Ticks);
+    // and look for a key, in place of the receive interrupt
+    Terminal_HostPoll();
+  }
+  return true;  // always return true to allow loop test in ES_Run to proceed
+}
+
+/****************************************************************************
+ Function
+     _HW_ConsoleInit
+ Parameters
+     none
+ Returns
+     none.
+ Description
+  Initializes the console I/O
+ Notes
+ real work is in terminal_Host.c. Derived from _HW_ConsoleInit in ES_Port.c
+ Author
+     M. Saboo, 10/16/26 09:12
+ ****************************************************************************/
+void _HW_ConsoleInit(void)
+{
+  Terminal_HWInit();
+}
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,233 @@
+/****************************************************************************
+ Module
+     ES_Profile.c
+ Description
+     Optional run time profiling of the services. Keeps, for each service,
+     the number of events run, the min/average/max time taken by the run
+     function with a log2 histogram of those times, the high water mark of
+     its queue and the number of posts that failed because it was full.
+ Notes
+     Only compiled when ES_PROFILE is defined in ES_Configure.h. The times
+     are core timer counts, 50nS each (2 SYSCLKs on the PIC32).
+     ES_Profile_Report prints everything to the terminal. It waits for the
+     transmit buffer to drain after each service, so the framework stalls
+     for a few mS while a report is being printed.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 11:00 mss      uses Terminal_Flush in place of its own copy
+ 10/16/26 16:00 mss      started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_General.h"
+#include "ES_LookupTables.h"
+#include "ES_Profile.h"
+#include "terminal.h"
+
+#ifdef ES_PROFILE
+
+#include <stdio.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  uint32_t  NumRuns;
+  uint32_t  MinCounts;
+  uint32_t  MaxCounts;
+  uint64_t  TotalCounts;
+  uint16_t  Histogram[ES_PROFILE_BUCKETS];
+  uint16_t  NumFailedPosts;
+  uint8_t   HighWater;
+}ServiceProfile_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+
+/*---------------------------- Module Variables ---------------------------*/
+static ServiceProfile_t Profiles[NUM_SERVICES];
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Profile_NoteRun
+ Parameters
+   uint8_t : Which service just ran
+   uint32_t : how long its run function took, in core timer counts
+ Returns
+   nothing
+ Description
+   adds one run to the statistics for the service
+ Notes
+   called by ES_Run through ES_PROFILE_RUN_END
+ Author
+   M. Saboo, 10/16/26, 16:00
+****************************************************************************/
+void ES_Profile_NoteRun(uint8_t WhichService, uint32_t Counts)
+{
+  ServiceProfile_t  *pProfile = &Profiles[WhichService];
+  uint8_t           Bucket;
+
+  if ((pProfile->NumRuns == 0) || (Counts < pProfile->MinCounts))
+  {
+    pProfile->MinCounts = Counts;
+  }
+  if (Counts > pProfile->MaxCounts)
+  {
+    pProfile->MaxCounts = Counts;
+  }
+  pProfile->NumRuns++;
+  pProfile->TotalCounts += Counts;
+
+  Bucket = (Counts == 0) ? 0 : ES_MSBitOfNonZero(Counts);
+  if (Bucket >= ES_PROFILE_BUCKETS)
+  {
+    Bucket = ES_PROFILE_BUCKETS - 1;
+  }
+  if (pProfile->Histogram[Bucket] != UINT16_MAX)  // saturate, don't wrap
+  {
+    pProfile->Histogram[Bucket]++;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_NotePost
+ Parameters
+   uint8_t : Which service was posted to
+   uint8_t : number of entries in its queue after the post
+ Returns
+   nothing
+ Description
+   keeps the high water mark of the service's queue
+ Notes
+   may be called from an ISR. A race with another post can at worst miss
+   a new high water mark by one entry
+ Author
+   M. Saboo, 10/16/26, 16:00
+****************************************************************************/
+void ES_Profile_NotePost(uint8_t WhichService, uint8_t NumEntries)
+{
+  if (NumEntries > Profiles[WhichService].HighWater)
+  {
+    Profiles[WhichService].HighWater = NumEntries;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_NotePostFailed
+ Parameters
+   uint8_t : Which service's queue was full
+ Returns
+   nothing
+ Description
+   counts a failed post to the service
+ Notes
+   may be called from an ISR
+ Author
+   M. Saboo, 10/16/26, 16:00
+****************************************************************************/
+void ES_Profile_NotePostFailed(uint8_t WhichService)
+{
+  if (Profiles[WhichService].NumFailedPosts != UINT16_MAX)
+  {
+    __atomic_fetch_add(&Profiles[WhichService].NumFailedPosts, 1,
+        __ATOMIC_RELAXED);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Report
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   prints the profile of every service to the terminal
+ Notes
+   called from Check4Keystroke when ES_PROFILE_KEY is pressed
+ Author
+   M. Saboo, 10/16/26, 16:00
+****************************************************************************/
+void ES_Profile_Report(void)
+{
+  ServiceProfile_t  *pProfile;
+  uint8_t           i;
+  uint8_t           Bucket;
+
+  printf("\r\nsvc     runs    min    avg    max  maxwait queue fails"
+      "  (times in 50nS counts)\r\n");
+  Terminal_Flush();
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    pProfile = &Profiles[i];
+    printf("%3u %8lu %6lu %6lu %6lu %8lu %2u/%-2u %5u\r\n", i,
+        (unsigned long)pProfile->NumRuns,
+        (unsigned long)pProfile->MinCounts,
+        (unsigned long)((pProfile->NumRuns == 0) ? 0 :
+        (pProfile->TotalCounts / pProfile->NumRuns)),
+        (unsigned long)pProfile->MaxCounts,
+        (unsigned long)ES_GetMaxWait(i),
+        pProfile->HighWater, ES_GetQueueSize(i),
+        pProfile->NumFailedPosts);
+    // only the buckets that have something in them, as 2^bucket:count
+    if (pProfile->NumRuns != 0)
+    {
+      printf("    log2 hist:");
+      for (Bucket = 0; Bucket < ES_PROFILE_BUCKETS; Bucket++)
+      {
+        if (pProfile->Histogram[Bucket] != 0)
+        {
+          printf(" %u:%u", Bucket, pProfile->Histogram[Bucket]);
+        }
+      }
+      printf("\r\n");
+    }
+    Terminal_Flush();
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Clear
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   starts all of the statistics over, including the worst case waits
+ Author
+   M. Saboo, 10/16/26, 16:00
+****************************************************************************/
+void ES_Profile_Clear(void)
+{
+  uint8_t i;
+  uint8_t Bucket;
+
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    Profiles[i].NumRuns         = 0;
+    Profiles[i].MinCounts       = 0;
+    Profiles[i].MaxCounts       = 0;
+    Profiles[i].TotalCounts     = 0;
+    Profiles[i].NumFailedPosts  = 0;
+    Profiles[i].HighWater       = 0;
+    for (Bucket = 0; Bucket < ES_PROFILE_BUCKETS; Bucket++)
+    {
+      Profiles[i].Histogram[Bucket] = 0;
+    }
+  }
+  ES_ClearMaxWaits();
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+#endif /* ES_PROFILE */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
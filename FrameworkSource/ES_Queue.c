@@ -9,6 +9,11 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 10:20 mss      removed the SPSC queue kind and its benchmark, the
+                         service queues are in ES_Framework.c, these queues
+                         are only used for deferral now
+ 10/16/26 10:05 mss      added the lock-free single-producer/single-consumer
+                         (SPSC) queue kind and the latency benchmark
  01/15/12 09:34 jec      converted to use the new C99 types from types.h
  08/09/11 18:16 jec      started coding
 *****************************************************************************/
@@ -4,184 +4,320 @@
    ES_ShortTimer.c
 
  Revision
-   1.0.1
+   2.0.0
 
  Description
    This is a library to provide for the creation of short time-outs
    (shorter than the resolution of the ES_Timer library).
 
  Notes
-   This module uses the Tiva Peripheral Driver Library functions and
-   the ability that it provides to 'hook' a function into an interrupt
-   response routine without modifying the vector table directly.
-   Uses timers A & B on 16/32 bit Timer Module 5
+   Two independent one-shot channels, A on Timer4 and B on Timer5, each
+   posting ES_SHORT_TIMEOUT (EventParam = the channel) to the service given
+   to ES_ShortTimerInit. Times are in uS, from 1 to 65535.
+   The timers run from PBCLK (20MHz) / 4, so a timeout is accurate to 0.2uS.
+   A 16 bit timer only reaches 13.1mS at that rate, so longer timeouts are
+   run as several periods, the ISR setting up the next one.
+   Starting a channel that is already running starts it over from now, and
+   ES_ShortTimerStop cancels it. A timeout that has already been posted is
+   not taken back, so a service that stops a channel may still find one
+   ES_SHORT_TIMEOUT from it in its queue.
+   Latency: the ES_SHORT_TIMEOUT is in the service's queue about 2uS after
+   the time asked for. That is up to 1 timer count (0.2uS) for the timer to
+   sync to its prescaler, about 0.5uS of interrupt latency and context save
+   at 40MHz, and about 1.5uS for ES_PostToServiceFromISR. These are
+   estimates, scope the DEBUG line to measure them. Timeouts shorter than
+   ES_SHORT_TIMER_MIN_US would be late anyway, so they are posted at once.
+   When the service then runs depends on what else ES_Run has to do.
+   Only call the start and stop functions from services, they use
+   EnterCritical/ExitCritical, which can not be nested.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 02:00 mss     ported to the PIC32 Timer4 & 5, added cancel and
+                        timeouts longer than one period of the timer
  10/11/15 10:30 jec     first pass
  10/11/15 18:10 jec     converted to post events to the framework
 
 ****************************************************************************/
 // the common headers for I/O, C99 types
-#include <stdio.h>
+#include <xc.h>
+#include <sys/attribs.h>    // for ISR macros
 #include <stdint.h>
 #include <stdbool.h>
-#include "BITDEFS.H"
-
-// the headers to access the GPIO subsystem
-#include "inc/hw_memmap.h"
-#include "inc/hw_types.h"
-#include "inc/hw_gpio.h"
-#include "inc/hw_sysctl.h"
-#include "inc/hw_timer.h"
-#include "inc/hw_ints.h"
-
-// the headers to access the TivaWare Library
-#include "driverlib/sysctl.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/gpio.h"
-#include "driverlib/timer.h"
-#include "driverlib/interrupt.h"
 
 // the header to get the timing functions
 #include "ES_ShortTimer.h"
 
 // the framework headers
-#include "ES_Framework.h"
 #include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
 
-// module level functions
+/*----------------------------- Module Defines ----------------------------*/
+// Timer4 & 5 count PBCLK (20MHz) / 4, 5 counts per uS
+#define PRESCALE_1_4 0b010
+#define COUNTS_PER_US 5
+// the longest period of a 16 bit timer
+#define MAX_PERIOD_COUNTS 0x10000
+// the shortest period that a long timeout is allowed to end with, so that
+// the ISR has set it up well before the timer gets there
+#define MIN_PERIOD_COUNTS 100
+// interrupt priority, must match the IPL in the __ISR()s below. Above the
+// core timer tick (3), so that the tick ISR never delays a timeout
+#define SHORT_TIMER_PRIORITY 6
 
-// define for the timer pre-scaler. this sets the resolution of the
-// timing functions
-// the current values are based on a 40mHz clock rate to give 1uS resolution
-#define PRE_1uS 40
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  volatile uint32_t *pCon;      // TxCON
+  volatile uint32_t *pTmr;      // TMRx
+  volatile uint32_t *pPr;       // PRx
+  uint32_t          IntMask;    // TxIF in IFS0, the same bit as TxIE in IEC0
+}ChannelHW_t;
 
-void ShortTimerAHandler(void);
-void ShortTimerBHandler(void);
+/*---------------------------- Module Functions ---------------------------*/
+static void SetNextPeriod(ES_ShortTimer_t Which);
+static void ChannelISR(ES_ShortTimer_t Which);
 
-// module level variables
+/*---------------------------- Module Variables ---------------------------*/
+static ChannelHW_t const ChannelHW[ES_NUM_SHORT_TIMERS] =
+{
+  { &T4CON, &TMR4, &PR4, _IFS0_T4IF_MASK },
+  { &T5CON, &TMR5, &PR5, _IFS0_T5IF_MASK }
+};
 
-static uint8_t  Timer_A_Priority  = SHORT_TIMER_UNUSED;
-static uint8_t  Timer_B_Priority  = SHORT_TIMER_UNUSED;
+// the service that each channel posts to
+static uint8_t ChannelOwner[ES_NUM_SHORT_TIMERS] =
+{
+  SHORT_TIMER_UNUSED, SHORT_TIMER_UNUSED
+};
 
-//******************************
-// ES_ShortTimerInit()
-// Initialize the timer subsystem and log the services to which the timeout
-// messages will be posted
-//******************************
+// timer counts still to go after the current period of each channel
+static volatile uint32_t CountsLeft[ES_NUM_SHORT_TIMERS];
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_ShortTimerInit
+ Parameters
+   uint8_t TimeAPrio, the service that channel A posts to
+   uint8_t TimeBPrio, the service that channel B posts to
+ Returns
+   nothing
+ Description
+   sets up Timer4 & 5 as 16 bit timers, stopped, with their interrupts
+   enabled, and logs the services to which the timeouts will be posted
+ Notes
+   pass SHORT_TIMER_UNUSED for a channel that is not used
+ Author
+   J. Edward Carryer, 10/11/15 10:30
+****************************************************************************/
 void ES_ShortTimerInit(uint8_t TimeAPrio, uint8_t TimeBPrio)
 {
+  uint8_t Which;
+
 #ifdef DEBUG
-// set up I/O lines for debugging
-  SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
-  GPIOPinTypeGPIOOutput(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
-// start with the lines low
-  GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1, BIT0LO & BIT1LO);
+  // RB15 (the LED_DEBUG line in ES_Port.c) goes high when a channel is
+  // started and low in its ISR
+  ANSELBbits.ANSB15 = 0;
+  LATBbits.LATB15   = 0;
+  TRISBbits.TRISB15 = 0;
 #endif
-
-// enable the clock to the timer module
-  SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER5);
-// configure as 2 16 bit timers
-  TimerConfigure(TIMER5_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_ONE_SHOT |
-      TIMER_CFG_B_ONE_SHOT);
-// set prescale to get 1uS resolution
-  TimerPrescaleSet(TIMER5_BASE, TIMER_BOTH, PRE_1uS);
-// log the service to which the timeout will be posted
-  Timer_A_Priority  = TimeAPrio;
-  Timer_B_Priority  = TimeBPrio;
+  ChannelOwner[ES_SHORT_TIMER_A] = TimeAPrio;
+  ChannelOwner[ES_SHORT_TIMER_B] = TimeBPrio;
+  for (Which = 0; Which < ES_NUM_SHORT_TIMERS; Which++)
+  {
+    // off, PBCLK, 16 bit mode (T32 = 0 on Timer4), prescale of 4
+    *ChannelHW[Which].pCon  = PRESCALE_1_4 << _T4CON_TCKPS_POSITION;
+    CountsLeft[Which]       = 0;
+    IFS0CLR = ChannelHW[Which].IntMask;
+    IEC0SET = ChannelHW[Which].IntMask;
+  }
+  IPC4bits.T4IP = SHORT_TIMER_PRIORITY;
+  IPC5bits.T5IP = SHORT_TIMER_PRIORITY;
 }
 
-void ES_ShortTimerStart(uint32_t Which, uint16_t TimeoutValue)
+/****************************************************************************
+ Function
+   ES_ShortTimerStart
+ Parameters
+   ES_ShortTimer_t Which, the channel to start
+   uint16_t TimeoutValue, the time until the timeout in uS
+ Returns
+   nothing
+ Description
+   starts (or starts over) the channel, to post ES_SHORT_TIMEOUT after
+   TimeoutValue uS
+ Notes
+   a channel with no service, or a time of 0, is ignored
+ Author
+   J. Edward Carryer, 10/11/15 10:30
+****************************************************************************/
+void ES_ShortTimerStart(ES_ShortTimer_t Which, uint16_t TimeoutValue)
 {
-  if ((Which != TIMER_A) && (Which != TIMER_B))
+  ES_Event_t ThisEvent;
+
+  if ((Which >= ES_NUM_SHORT_TIMERS) ||
+      (ChannelOwner[Which] == SHORT_TIMER_UNUSED) || (TimeoutValue == 0))
   {
     return;
   }
-  // for very short delays. just immediatly post. There is 10us of overhead
-  if (TimeoutValue < 11)
+  ES_ShortTimerStop(Which);
+  // for very short delays, just immediately post
+  if (TimeoutValue < ES_SHORT_TIMER_MIN_US)
   {
-    if (Which == TIMER_A)
-    {
-      ShortTimerAHandler();
-    }
-    else
-    {
-      ShortTimerBHandler();
-    }
+    ThisEvent.EventType   = ES_SHORT_TIMEOUT;
+    ThisEvent.EventParam  = Which;
+    ES_PostToService(ChannelOwner[Which], ThisEvent);
+    return;
   }
-  TimerLoadSet(TIMER5_BASE, Which, TimeoutValue);
+  EnterCritical();
+  CountsLeft[Which] = (uint32_t)TimeoutValue * COUNTS_PER_US;
+  SetNextPeriod(Which);
+  *ChannelHW[Which].pTmr  = 0;
+  *ChannelHW[Which].pCon |= _T4CON_ON_MASK;
+  ExitCritical();
+#ifdef DEBUG
+  // raise I/O line to show we started
+  LATBbits.LATB15 = 1;
+#endif
+}
 
-  if (Which == TIMER_A) // local enable
-  {
-    TimerIntEnable(TIMER5_BASE, TIMER_TIMA_TIMEOUT);
-    // NVIC Enable
-    IntEnable(INT_TIMER5A_TM4C123);
-  }
-  else
+/****************************************************************************
+ Function
+   ES_ShortTimerStop
+ Parameters
+   ES_ShortTimer_t Which, the channel to stop
+ Returns
+   nothing
+ Description
+   cancels the channel's timeout, if it is running
+ Notes
+   does nothing to a timeout that was already posted
+ Author
+   M. Saboo, 10/17/26, 02:00
+****************************************************************************/
+void ES_ShortTimerStop(ES_ShortTimer_t Which)
+{
+  if (Which >= ES_NUM_SHORT_TIMERS)
   {
-    // local enable
-    TimerIntEnable(TIMER5_BASE, TIMER_TIMB_TIMEOUT);
-    // NVIC Enable
-    IntEnable(INT_TIMER5B_TM4C123);
+    return;
   }
+  EnterCritical();
+  *ChannelHW[Which].pCon &= ~_T4CON_ON_MASK;
+  IFS0CLR = ChannelHW[Which].IntMask;
+  CountsLeft[Which] = 0;
+  ExitCritical();
+}
 
-  TimerEnable(TIMER5_BASE, Which);
+/****************************************************************************
+ Function
+   ES_ShortTimerIsRunning
+ Parameters
+   ES_ShortTimer_t Which, the channel to test
+ Returns
+   bool, true if the channel has been started and not yet timed out
+ Author
+   M. Saboo, 10/17/26, 02:00
+****************************************************************************/
+bool ES_ShortTimerIsRunning(ES_ShortTimer_t Which)
+{
+  return (Which < ES_NUM_SHORT_TIMERS) &&
+         ((*ChannelHW[Which].pCon & _T4CON_ON_MASK) != 0);
+}
 
-#ifdef DEBUG
-// raise I/O line to show we started
-  if (Which == TIMER_A)
-  {
-    GPIOPinWrite(GPIO_PORTB_BASE, BIT0HI, BIT0HI);
-  }
-  else
-  {
-    GPIOPinWrite(GPIO_PORTB_BASE, BIT1HI, BIT1HI);
-  }
-#endif
-  return;
+/****************************************************************************
+ Function
+   ShortTimerAHandler, ShortTimerBHandler
+ Description
+   the Timer4 & 5 interrupt responses
+ Author
+   J. Edward Carryer, 10/11/15 18:10
+****************************************************************************/
+void __ISR(_TIMER_4_VECTOR, IPL6AUTO) ShortTimerAHandler(void)
+{
+  ChannelISR(ES_SHORT_TIMER_A);
 }
 
-void ShortTimerAHandler(void)
+void __ISR(_TIMER_5_VECTOR, IPL6AUTO) ShortTimerBHandler(void)
 {
-  ES_Event_t ThisEvent;
+  ChannelISR(ES_SHORT_TIMER_B);
+}
 
-// start by clearing the source of the interrupt
-  TimerIntClear(TIMER5_BASE, TIMER_TIMA_TIMEOUT);
-#ifdef DEBUG
-// lower I/O line to show we arrived
-  GPIOPinWrite(GPIO_PORTB_BASE, BIT0HI, BIT0LO);
-#endif
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   SetNextPeriod
+ Parameters
+   ES_ShortTimer_t Which, the channel
+ Returns
+   nothing
+ Description
+   sets the period register for the next part of the channel's timeout
+   and takes it off of the counts left
+ Notes
+   the timer counts PRx + 1 counts per period
+ Author
+   M. Saboo, 10/17/26, 02:00
+****************************************************************************/
+static void SetNextPeriod(ES_ShortTimer_t Which)
+{
+  uint32_t Counts = CountsLeft[Which];
 
-// post the timeout for this timer
-  ThisEvent.EventType   = ES_SHORT_TIMEOUT;
-  ThisEvent.EventParam  = TIMER_A;
-// protect against timer that was not correctly initialized
-  if (Timer_A_Priority != SHORT_TIMER_UNUSED)
+  if (Counts > MAX_PERIOD_COUNTS)
   {
-    ES_PostToService(Timer_A_Priority, ThisEvent);
+    // split what is left in 2 rather than leave a last period so short
+    // that the timer could pass it before the ISR sets it
+    Counts = (Counts < (MAX_PERIOD_COUNTS + MIN_PERIOD_COUNTS)) ?
+        (Counts / 2) : MAX_PERIOD_COUNTS;
   }
+  CountsLeft[Which]    -= Counts;
+  *ChannelHW[Which].pPr = Counts - 1;
 }
 
-void ShortTimerBHandler(void)
+/****************************************************************************
+ Function
+   ChannelISR
+ Parameters
+   ES_ShortTimer_t Which, the channel whose timer period ended
+ Returns
+   nothing
+ Description
+   sets up the next period of a long timeout, or stops the timer and
+   posts ES_SHORT_TIMEOUT to the channel's service
+ Notes
+   the timer has already started its next period from 0, so only the
+   period register needs to change
+ Author
+   J. Edward Carryer, 10/11/15 18:10
+****************************************************************************/
+static void ChannelISR(ES_ShortTimer_t Which)
 {
   ES_Event_t ThisEvent;
 
-// start by clearing the source of the interrupt
-  TimerIntClear(TIMER5_BASE, TIMER_TIMB_TIMEOUT);
+  // start by clearing the source of the interrupt
+  IFS0CLR = ChannelHW[Which].IntMask;
+  if (CountsLeft[Which] != 0)
+  {
+    SetNextPeriod(Which);
+    return;
+  }
+  *ChannelHW[Which].pCon &= ~_T4CON_ON_MASK;
 #ifdef DEBUG
-// lower I/O line to show we arrived
-  GPIOPinWrite(GPIO_PORTB_BASE, BIT1HI, BIT1LO);
+  // lower I/O line to show we arrived
+  LATBbits.LATB15 = 0;
 #endif
-
-// post the timeout for this timer
+  // post the timeout for this timer
   ThisEvent.EventType   = ES_SHORT_TIMEOUT;
-  ThisEvent.EventParam  = TIMER_B;
-// protect against timer that was not correctly initialized
-  if (Timer_B_Priority != SHORT_TIMER_UNUSED)
+  ThisEvent.EventParam  = Which;
+  // protect against timer that was not correctly initialized
+  if (ChannelOwner[Which] != SHORT_TIMER_UNUSED)
   {
-    ES_PostToService(Timer_B_Priority, ThisEvent);
+    ES_PostToServiceFromISR(ChannelOwner[Which], ThisEvent);
   }
 }
-
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
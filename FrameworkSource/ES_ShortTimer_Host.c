@@ -0,0 +1,184 @@
+/****************************************************************************
+ Module
+   ES_ShortTimer_Host.c
+
+ Revision
+   1.0.1
+
+ Description
+   Linux host stand-in for ES_ShortTimer.c, so that services using the
+   short timers can be run and tested on a PC.
+
+ Notes
+   Built in place of ES_ShortTimer.c when using the ES_HOST_PORT
+   configuration. Each channel keeps its deadline as a simulated core timer
+   count (see ES_Port_Host.c). There are no interrupts on the host, so
+   _HW_Process_Pending_Ints calls ES_ShortTimer_HostPoll, which posts the
+   ES_SHORT_TIMEOUT of every channel whose deadline has passed. The
+   timeouts are therefore only as prompt as ES_Run's loop, usually a few
+   uS, not the PIC32's 2uS.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 02:00 mss     first pass, derived from ES_ShortTimer.c
+****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ES_ShortTimer.h"
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+/*---------------------------- Module Functions ---------------------------*/
+static void PostTimeout(ES_ShortTimer_t Which);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the service that each channel posts to
+static uint8_t ChannelOwner[ES_NUM_SHORT_TIMERS] =
+{
+  SHORT_TIMER_UNUSED, SHORT_TIMER_UNUSED
+};
+
+// the core timer count at which each running channel times out
+static uint32_t Deadline[ES_NUM_SHORT_TIMERS];
+static bool     IsRunning[ES_NUM_SHORT_TIMERS];
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_ShortTimerInit
+ Parameters
+   uint8_t TimeAPrio, the service that channel A posts to
+   uint8_t TimeBPrio, the service that channel B posts to
+ Returns
+   nothing
+ Description
+   logs the services to which the timeouts will be posted, with both
+   channels stopped
+ Author
+   J. Edward Carryer, 10/11/15 10:30
+****************************************************************************/
+void ES_ShortTimerInit(uint8_t TimeAPrio, uint8_t TimeBPrio)
+{
+  ChannelOwner[ES_SHORT_TIMER_A]  = TimeAPrio;
+  ChannelOwner[ES_SHORT_TIMER_B]  = TimeBPrio;
+  IsRunning[ES_SHORT_TIMER_A]     = false;
+  IsRunning[ES_SHORT_TIMER_B]     = false;
+}
+
+/****************************************************************************
+ Function
+   ES_ShortTimerStart
+ Parameters
+   ES_ShortTimer_t Which, the channel to start
+   uint16_t TimeoutValue, the time until the timeout in uS
+ Returns
+   nothing
+ Description
+   starts (or starts over) the channel, to post ES_SHORT_TIMEOUT after
+   TimeoutValue uS
+ Notes
+   a channel with no service, or a time of 0, is ignored
+ Author
+   J. Edward Carryer, 10/11/15 10:30
+****************************************************************************/
+void ES_ShortTimerStart(ES_ShortTimer_t Which, uint16_t TimeoutValue)
+{
+  if ((Which >= ES_NUM_SHORT_TIMERS) ||
+      (ChannelOwner[Which] == SHORT_TIMER_UNUSED) || (TimeoutValue == 0))
+  {
+    return;
+  }
+  IsRunning[Which] = false;
+  if (TimeoutValue < ES_SHORT_TIMER_MIN_US)
+  {
+    PostTimeout(Which);
+    return;
+  }
+  Deadline[Which] = _CP0_GET_COUNT() +
+      ((uint32_t)TimeoutValue * ES_CORE_COUNTS_PER_US);
+  IsRunning[Which] = true;
+}
+
+/****************************************************************************
+ Function
+   ES_ShortTimerStop
+ Parameters
+   ES_ShortTimer_t Which, the channel to stop
+ Returns
+   nothing
+ Description
+   cancels the channel's timeout, if it is running
+ Author
+   M. Saboo, 10/17/26, 02:00
+****************************************************************************/
+void ES_ShortTimerStop(ES_ShortTimer_t Which)
+{
+  if (Which < ES_NUM_SHORT_TIMERS)
+  {
+    IsRunning[Which] = false;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_ShortTimerIsRunning
+ Parameters
+   ES_ShortTimer_t Which, the channel to test
+ Returns
+   bool, true if the channel has been started and not yet timed out
+ Author
+   M. Saboo, 10/17/26, 02:00
+****************************************************************************/
+bool ES_ShortTimerIsRunning(ES_ShortTimer_t Which)
+{
+  return (Which < ES_NUM_SHORT_TIMERS) && IsRunning[Which];
+}
+
+/****************************************************************************
+ Function
+   ES_ShortTimer_HostPoll
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   posts the timeout of every running channel whose deadline has passed,
+   the stand-in for the Timer4 & 5 interrupts
+ Notes
+   called from _HW_Process_Pending_Ints in ES_Port_Host.c
+ Author
+   M. Saboo, 10/17/26, 02:00
+****************************************************************************/
+void ES_ShortTimer_HostPoll(void)
+{
+  uint32_t  Now = _CP0_GET_COUNT();
+  uint8_t   Which;
+
+  for (Which = 0; Which < ES_NUM_SHORT_TIMERS; Which++)
+  {
+    // the signed test handles the wrap of the count
+    if (IsRunning[Which] && ((int32_t)(Now - Deadline[Which]) >= 0))
+    {
+      IsRunning[Which] = false;
+      PostTimeout(Which);
+    }
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void PostTimeout(ES_ShortTimer_t Which)
+{
+  ES_Event_t ThisEvent;
+
+  ThisEvent.EventType   = ES_SHORT_TIMEOUT;
+  ThisEvent.EventParam  = Which;
+  ES_PostToService(ChannelOwner[Which], ThisEvent);
+}
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,343 @@
+/****************************************************************************
+ Module
+     ES_TimerStats.c
+ Description
+     Optional statistics on how late the framework timers are. Keeps, for
+     each timer, the number of ES_TIMEOUTs run, the worst lateness and a
+     log2 histogram of the lateness, where lateness is the time from the
+     deadline the timer was programmed for (the core count of its tick) to
+     ES_Run taking its ES_TIMEOUT from the queue. Also counts how often
+     ticks had to be caught up, in the tick ISR and in ES_Run, and the most
+     ticks caught up at once.
+ Notes
+     Only compiled when ES_TIMER_STATS is defined in ES_Configure.h. The
+     times are core timer counts, 50nS each.
+     Since the lateness starts at the deadline, it takes in the time that
+     the tick waited for ES_Run to get to it, behind a long run function
+     or event checker, as well as any ticks that were caught up at once.
+     The tick ISR catch-up counts the times that interrupts were off for
+     more than a tick. The ES_Run catch-up counts the times that the timers
+     were more than a tick behind when ES_Run got to them. With ES_TICKLESS,
+     the ticks that _HW_IdleWait slept through arrive along with the tick
+     that ends the sleep. The port passes them to ES_TIMER_STATS_SLEPT so
+     that they are not counted as a catch-up.
+     Callback timers are run as they expire, so they are not in the
+     histograms.
+     ES_TimerStats_Report prints everything to the terminal. It waits for
+     the transmit buffer to drain after each timer, so the framework stalls
+     for a few mS while a report is being printed.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 11:20 mss      lateness is timed from the deadline rather than
+                         from ES_Timer_Advance posting the timeout
+ 10/17/26 11:00 mss      ticks slept through by ES_TICKLESS are no longer
+                         counted as ES_Run catch-ups. The number of timers
+                         and the terminal drain now come from ES_Timers.h
+                         and terminal.c
+ 10/17/26 03:00 mss      started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_General.h"
+#include "ES_LookupTables.h"
+#include "ES_Port.h"
+#include "ES_Timers.h"
+#include "ES_TimerStats.h"
+#include "terminal.h"
+
+#ifdef ES_TIMER_STATS
+
+#include <stdio.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// bucket 0 holds everything under 2^(FIRST_BUCKET_BITS) counts
+#define FIRST_BUCKET_BITS 6
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  uint32_t  ExpiredAt;    // core timer count of the deadline
+  uint32_t  NumTimeouts;
+  uint32_t  MaxCounts;
+  uint16_t  Histogram[ES_TIMER_STATS_BUCKETS];
+  bool      IsQueued;     // ExpiredAt is for a timeout not yet run
+}TimerStats_t;
+
+typedef struct
+{
+  uint32_t  NumCatchUps;
+  uint32_t  MaxTicks;
+}CatchUpStats_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void NoteCatchUp(CatchUpStats_t *pStats, uint32_t Ticks);
+
+/*---------------------------- Module Variables ---------------------------*/
+static TimerStats_t   Stats[ES_NUM_TIMERS];
+static CatchUpStats_t IsrCatchUps;
+static CatchUpStats_t RunCatchUps;
+// of the ticks about to be passed to ES_Timer_Advance, those slept through
+static uint32_t       SleptTicks;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_TimerStats_NoteExpiry
+ Parameters
+   uint8_t : Num, the timer whose ES_TIMEOUT was just posted
+   uint32_t : DueAt, the core count of the tick it was due on
+ Returns
+   nothing
+ Description
+   time stamps the expiry, for ES_TimerStats_NoteDispatch
+ Notes
+   called by ES_Timer_Advance through ES_TIMER_STATS_EXPIRED
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+void ES_TimerStats_NoteExpiry(uint8_t Num, uint32_t DueAt)
+{
+  Stats[Num].ExpiredAt  = DueAt;
+  Stats[Num].IsQueued   = true;
+}
+
+/****************************************************************************
+ Function
+   ES_TimerStats_NoteDispatch
+ Parameters
+   uint16_t : Num, the EventParam of an ES_TIMEOUT that ES_Run is about to
+   run
+ Returns
+   nothing
+ Description
+   adds the time since the timer expired to the timer's statistics
+ Notes
+   called by ES_Timer_TimeoutDispatched through ES_TIMER_STATS_DISPATCHED.
+   An ES_TIMEOUT that did not come from an expiry (a service may post its
+   own) is ignored
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+void ES_TimerStats_NoteDispatch(uint16_t Num)
+{
+  TimerStats_t  *pStats;
+  uint32_t      Counts;
+  uint8_t       Bucket;
+
+  if ((Num >= ES_NUM_TIMERS) || !Stats[Num].IsQueued)
+  {
+    return;
+  }
+  pStats            = &Stats[Num];
+  Counts            = _CP0_GET_COUNT() - pStats->ExpiredAt;
+  pStats->IsQueued  = false;
+  // a catch-up can credit its last tick up to half a tick early, so a
+  // timeout run right away may be run before its deadline
+  if ((int32_t)Counts < 0)
+  {
+    Counts = 0;
+  }
+  pStats->NumTimeouts++;
+  if (Counts > pStats->MaxCounts)
+  {
+    pStats->MaxCounts = Counts;
+  }
+
+  Bucket = (Counts >> FIRST_BUCKET_BITS) == 0 ? 0 :
+      (ES_MSBitOfNonZero(Counts) - FIRST_BUCKET_BITS + 1);
+  if (Bucket >= ES_TIMER_STATS_BUCKETS)
+  {
+    Bucket = ES_TIMER_STATS_BUCKETS - 1;
+  }
+  if (pStats->Histogram[Bucket] != UINT16_MAX)  // saturate, don't wrap
+  {
+    pStats->Histogram[Bucket]++;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_TimerStats_NoteAdvance
+ Parameters
+   uint32_t : Ticks, the number of ticks the timers are being moved on by
+ Returns
+   nothing
+ Description
+   counts a catch-up by ES_Run when, leaving out any ticks that were slept
+   through, there is more than 1 tick
+ Notes
+   called by ES_Timer_Advance through ES_TIMER_STATS_ADVANCE
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+void ES_TimerStats_NoteAdvance(uint32_t Ticks)
+{
+  Ticks      -= (SleptTicks < Ticks) ? SleptTicks : Ticks;
+  SleptTicks  = 0;
+  if (Ticks > 1)
+  {
+    NoteCatchUp(&RunCatchUps, Ticks);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_TimerStats_NoteSlept
+ Parameters
+   uint32_t : Ticks, how many of the ticks for the next ES_Timer_Advance
+   passed while _HW_IdleWait had the processor asleep
+ Returns
+   nothing
+ Description
+   keeps the ticks slept through out of the next ES_Run catch-up
+ Notes
+   called by _HW_Process_Pending_Ints through ES_TIMER_STATS_SLEPT, just
+   before it calls ES_Timer_Advance
+ Author
+   M. Saboo, 10/17/26, 11:00
+****************************************************************************/
+void ES_TimerStats_NoteSlept(uint32_t Ticks)
+{
+  SleptTicks += Ticks;
+}
+
+/****************************************************************************
+ Function
+   ES_TimerStats_NoteCatchUp
+ Parameters
+   uint32_t : Ticks, the number of ticks credited at once
+ Returns
+   nothing
+ Description
+   counts a run of the catch-up branch of the tick ISR
+ Notes
+   called from the tick ISR through ES_TIMER_STATS_CATCH_UP
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+void ES_TimerStats_NoteCatchUp(uint32_t Ticks)
+{
+  NoteCatchUp(&IsrCatchUps, Ticks);
+}
+
+/****************************************************************************
+ Function
+   ES_TimerStats_Report
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   prints the statistics of every timer that has run an ES_TIMEOUT, and
+   the catch-ups, to the terminal
+ Notes
+   called from Check4Keystroke when ES_TIMER_STATS_KEY is pressed
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+void ES_TimerStats_Report(void)
+{
+  TimerStats_t  *pStats;
+  uint8_t       Num;
+  uint8_t       Bucket;
+
+  printf("\r\ntmr timeouts  max late  (bucket b is under 3.2uS * 2^b)\r\n");
+  Terminal_Flush();
+  for (Num = 0; Num < ES_NUM_TIMERS; Num++)
+  {
+    pStats = &Stats[Num];
+    if (pStats->NumTimeouts == 0)
+    {
+      continue;
+    }
+    printf("%3u %8lu %7luuS  log2 hist:", Num,
+        (unsigned long)pStats->NumTimeouts,
+        (unsigned long)ES_COUNTS_TO_US(pStats->MaxCounts));
+    // only the buckets that have something in them, as bucket:count
+    for (Bucket = 0; Bucket < ES_TIMER_STATS_BUCKETS; Bucket++)
+    {
+      if (pStats->Histogram[Bucket] != 0)
+      {
+        printf(" %u:%u", Bucket, pStats->Histogram[Bucket]);
+      }
+    }
+    printf("\r\n");
+    Terminal_Flush();
+  }
+  printf("tick ISR catch-ups %lu, most ticks at once %lu\r\n",
+      (unsigned long)IsrCatchUps.NumCatchUps,
+      (unsigned long)IsrCatchUps.MaxTicks);
+  printf("ES_Run catch-ups %lu, most ticks at once %lu\r\n",
+      (unsigned long)RunCatchUps.NumCatchUps,
+      (unsigned long)RunCatchUps.MaxTicks);
+  Terminal_Flush();
+}
+
+/****************************************************************************
+ Function
+   ES_TimerStats_Clear
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   starts all of the statistics over
+ Notes
+   a timeout already in a queue is still measured when it is run
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+void ES_TimerStats_Clear(void)
+{
+  uint8_t Num;
+  uint8_t Bucket;
+
+  for (Num = 0; Num < ES_NUM_TIMERS; Num++)
+  {
+    Stats[Num].NumTimeouts  = 0;
+    Stats[Num].MaxCounts    = 0;
+    for (Bucket = 0; Bucket < ES_TIMER_STATS_BUCKETS; Bucket++)
+    {
+      Stats[Num].Histogram[Bucket] = 0;
+    }
+  }
+  EnterCritical();  // the ISR writes IsrCatchUps
+  IsrCatchUps.NumCatchUps = 0;
+  IsrCatchUps.MaxTicks    = 0;
+  ExitCritical();
+  RunCatchUps.NumCatchUps = 0;
+  RunCatchUps.MaxTicks    = 0;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   NoteCatchUp
+ Parameters
+   CatchUpStats_t * : the statistics to add to
+   uint32_t : Ticks, the number of ticks caught up
+ Returns
+   nothing
+ Description
+   counts the catch-up and keeps the most ticks caught up at once
+ Author
+   M. Saboo, 10/17/26, 03:00
+****************************************************************************/
+static void NoteCatchUp(CatchUpStats_t *pStats, uint32_t Ticks)
+{
+  if (pStats->NumCatchUps != UINT32_MAX)
+  {
+    pStats->NumCatchUps++;
+  }
+  if (Ticks > pStats->MaxTicks)
+  {
+    pStats->MaxTicks = Ticks;
+  }
+}
+
+#endif /* ES_TIMER_STATS */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -1,18 +1,58 @@
+//#define TIMER_BENCH
 /****************************************************************************
  Module
      ES_Timers.c
 
  Description
-     This is a module implementing  8 16 bit timers all using the RTI
-     timebase
+     This is a module implementing 16 numbered timers, plus a pool of
+     ES_TIMER_POOL_SIZE timers handed out at run time, all 32 bits and all
+     using the RTI timebase
 
  Notes
      Everything is done in terms of RTI Ticks, which can change from
      application to application.
+     The active timers are kept in a list sorted by the tick at which they
+     expire, so each tick only has to look at the head of the list, however
+     many timers are running. Starting a timer walks the list to find its
+     place, which is at most one step per timer and happens far less often
+     than the tick.
+     The numbered timers are tied to a service by the TIMERn_RESP_FUNC
+     settings in ES_Configure.h. A pool timer is tied to the service that
+     allocates it with ES_Timer_Alloc, and its ES_TIMEOUT carries the handle
+     as the EventParam. Once allocated, a handle is used with the same
+     functions as a timer number.
+     A periodic timer (ES_Timer_InitPeriodic) is re-armed by the tick from
+     its deadline, so the handling time never adds to the period. While
+     its last ES_TIMEOUT is still waiting to be run, further expiries are
+     counted as missed periods rather than posted again.
+     A timer given a callback with ES_Timer_SetCallback calls it from the
+     tick response instead of posting ES_TIMEOUT. Each call is timed, and a
+     callback that takes longer than ES_TIMER_CALLBACK_LIMIT is dropped so
+     that it can not hold up the tick again. The timer then goes back to
+     posting ES_TIMEOUT to its service.
 
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 11:20 mss      the timer statistics time each expiry from its
+                         deadline, see ExpiryCount
+ 10/17/26 11:00 mss      the number of timers comes from ES_Timers.h
+ 10/17/26 03:00 mss      added the ES_TIMER_STATS hooks
+ 10/17/26 01:00 mss      added the 64 bit core timer clock, ES_GetTime64 and
+                         ES_GetTime_us, with conversions to uS and mS
+ 10/17/26 00:00 mss      added ES_Timer_Advance, so that ticks missed while
+                         ints were off are caught up in one pass with the
+                         expiries in deadline order
+ 10/16/26 23:00 mss      added ES_Timer_TicksToNextExpiry for ES_TICKLESS
+ 10/16/26 22:00 mss      added callback timers, with a guard on their run time
+ 10/16/26 21:00 mss      added periodic timers and the count of missed periods
+ 10/16/26 20:00 mss      timers are now 32 bits, added the pool of timers
+                         allocated to a service with ES_Timer_Alloc
+ 10/16/26 19:00 mss      replaced the decrement of every active timer on
+                         each tick with a deadline sorted list, so a tick is
+                         O(1) plus the timers that expire. Added the
+                         TIMER_BENCH comparison with the old walk
+ 10/16/26 17:00 mss      added the ES_TRACE_TIMEOUT hook
  10/27/14 14:02 jec      moved ticking of 'time' to ES_Port to allow it to tick
                          even while blocking. required change to ES_GetTime too
  10/20/13 10:48 jec      moved definition of BITS_PER_BYTE to ES_General.h
@@ -50,48 +90,76 @@
 #include "../FrameworkHeaders/ES_LookupTables.h"
 #include "../FrameworkHeaders/ES_Timers.h"
 #include "../FrameworkHeaders/ES_Port.h"
+#include "../FrameworkHeaders/ES_Trace.h"
+#include "../FrameworkHeaders/ES_TimerStats.h"
 /*--------------------------- External Variables --------------------------*/
 
 /*----------------------------- Module Defines ----------------------------*/
+// marks the end of the list of active timers
+#define NO_TIMER 0xFF
+#define TimerBit(Num) ((Tflag_t)1 << (Num))
+
+#if ES_NUM_TIMERS > 64
+#error "ES_TIMER_POOL_SIZE is too big, there can be at most 64 timers"
+#endif
 
 /*------------------------------ Module Types -----------------------------*/
 
 /*
-   the size of Tflag sets the number of timers, uint8 = 8, uint16 = 16 ...)
-   to add more timers, you will need to change the data type and modify
-   the initialization of TMR_TimerArray and TMR_MaskArray
+   the size of Tflag limits the number of timers, the numbered timers plus
+   the pool must fit in it
 */
 
-typedef uint16_t Tflag_t;
+typedef uint64_t Tflag_t;
+
+typedef uint32_t Timer_t; // sets size of timers to 32 bits
 
-typedef uint16_t Timer_t; // sets size of timers to 16 bits
+// an active timer's place in the list sorted by expiry time
+typedef struct
+{
+  uint32_t  Deadline;   // value of TimerNow at which the timer expires
+  uint8_t   Next;       // the timer that expires after this one
+  uint8_t   Prev;       // the timer that expires before this one
+}TimerLink_t;
 
 /*---------------------------- Module Functions ---------------------------*/
+static void Enlist(uint8_t Num, Timer_t Ticks);
+static void Unlist(uint8_t Num);
+static bool HasService(uint8_t Num);
+static bool PostTimeout(uint8_t Num);
+static void RunCallback(uint8_t Num);
+static uint64_t DivideCounts(uint64_t Counts, uint32_t Divisor);
+static inline uint32_t ExpiryCount(uint32_t NewNow);
 
 /*---------------------------- Module Variables ---------------------------*/
-static Timer_t TMR_TimerArray[sizeof(Tflag_t) * BITS_PER_BYTE] =
-{
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0
-};
+// the time set on each timer. While a timer is stopped this is the time it
+// has left, and it is 0 once the timer has expired
+static Timer_t TMR_TimerArray[ES_NUM_TIMERS];
 
 static Tflag_t TMR_ActiveFlags;
 
-static pPostFunc const Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
+static TimerLink_t TimerLinks[ES_NUM_TIMERS];
+// head of the active list, the first timer to expire
+static uint8_t NextToExpire = NO_TIMER;
+// ticks processed since reset, the time base for the deadlines
+static uint32_t TimerNow;
+// the tick rate, in core timer counts per tick
+static TimerRate_t TickCounts;
+
+// the period of each periodic timer, 0 for a one-shot
+static Timer_t TimerPeriod[ES_NUM_TIMERS];
+// periodic timers whose last ES_TIMEOUT has not been run yet
+static Tflag_t TMR_PendingFlags;
+// expiries of each periodic timer that were not posted because the last
+// one was still pending, since the last ES_Timer_GetMissed
+static uint16_t MissedPeriods[ES_NUM_TIMERS];
+
+// the callback of each callback timer, NULL for a timer that posts
+static ES_TimerCallback_t TimerCallback[ES_NUM_TIMERS];
+// the longest that each callback has taken, in core timer counts
+static uint32_t CallbackMaxCounts[ES_NUM_TIMERS];
+
+static pPostFunc const Timer2PostFunc[ES_NUM_NUMBERED_TIMERS] =
 {
   TIMER0_RESP_FUNC,
   TIMER1_RESP_FUNC,
@@ -111,6 +179,17 @@ static pPostFunc const Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
   TIMER15_RESP_FUNC
 };
 
+// the upper 32 bits of the 64 bit core timer clock, and the Count register
+// at the last read, to catch it wrapping
+static uint32_t CountHigh;
+static uint32_t LastCount;
+
+// which pool timers have been allocated, and to which service
+#if ES_TIMER_POOL_SIZE > 0
+static bool     PoolInUse[ES_TIMER_POOL_SIZE];
+static uint8_t  PoolOwner[ES_TIMER_POOL_SIZE];
+#endif
+
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
@@ -132,14 +211,15 @@ void ES_Timer_Init(TimerRate_t Rate)
 {
   // call the hardware init routine
   _HW_Timer_Init(Rate);
+  TickCounts = Rate;
 }
 
 /****************************************************************************
  Function
      ES_Timer_SetTimer
  Parameters
-     unsigned char Num, the number of the timer to set.
-     unsigned int NewTime, the new time to set on that timer
+     unsigned char Num, the number (or handle) of the timer to set.
+     uint32_t NewTime, the new time to set on that timer
  Returns
      ES_Timer_ERR if requested timer does not exist or has no service
      ES_Timer_OK  otherwise
@@ -150,17 +230,23 @@ void ES_Timer_Init(TimerRate_t Rate)
  Author
      J. Edward Carryer, 02/24/97 17:11
 ****************************************************************************/
-ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint32_t NewTime)
 {
   /* tried to set a timer that doesn't exist */
-  if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
+  if ((Num >= ES_NUM_TIMERS) ||
       /* tried to set a timer without a service */
-      (Timer2PostFunc[Num] == TIMER_UNUSED) ||
+      !HasService(Num) ||
       (NewTime == 0))   /* no time being set */
   {
     return ES_Timer_ERR;
   }
   TMR_TimerArray[Num] = NewTime;
+  // a running timer carries on from the new time, as it always has
+  if (TMR_ActiveFlags & TimerBit(Num))
+  {
+    Unlist(Num);
+    Enlist(Num, NewTime);
+  }
   return ES_Timer_OK;
 }
 
@@ -172,23 +258,28 @@ ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
  Returns
      ES_Timer_ERR for error ES_Timer_OK for success
  Description
-     simply sets the active flag in TMR_ActiveFlags to (re)start a
-     stopped timer.
+     sets the active flag in TMR_ActiveFlags and puts the timer into the
+     active list to (re)start a stopped timer.
  Notes
-     None.
+     a stopped timer carries on with the time it had left. Starting a
+     timer that is already running has no effect.
  Author
      J. Edward Carryer, 02/24/97 14:45
 ****************************************************************************/
 ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num)
 {
   /* tried to set a timer that doesn't exist */
-  if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
+  if ((Num >= ES_NUM_TIMERS) ||
       /* tried to set a timer with no time on it */
       (TMR_TimerArray[Num] == 0))
   {
     return ES_Timer_ERR;
   }
-  TMR_ActiveFlags |= BitNum2SetMask[Num];  /* set timer as active */
+  if ((TMR_ActiveFlags & TimerBit(Num)) == 0)
+  {
+    Enlist(Num, TMR_TimerArray[Num]);
+    TMR_ActiveFlags |= TimerBit(Num);  /* set timer as active */
+  }
   return ES_Timer_OK;
 }
 
@@ -200,20 +291,25 @@ ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num)
  Returns
      ES_Timer_ERR for error (timer doesn't exist) ES_Timer_OK for success.
  Description
-     simply clears the bit in TMR_ActiveFlags associated with this
-     timer. This will cause it to stop counting.
+     clears the bit in TMR_ActiveFlags associated with this timer and
+     takes it out of the active list. This will cause it to stop counting.
  Notes
-     None.
+     the time left is saved in TMR_TimerArray for ES_Timer_StartTimer
  Author
      J. Edward Carryer, 02/24/97 14:48
 ****************************************************************************/
 ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
 {
-  if (Num >= ARRAY_SIZE(TMR_TimerArray))
+  if (Num >= ES_NUM_TIMERS)
   {
     return ES_Timer_ERR;    /* tried to set a timer that doesn't exist */
   }
-  TMR_ActiveFlags &= BitNum2ClrMask[Num];  /* set timer as inactive */
+  if (TMR_ActiveFlags & TimerBit(Num))
+  {
+    TMR_TimerArray[Num] = (Timer_t)(TimerLinks[Num].Deadline - TimerNow);
+    Unlist(Num);
+    TMR_ActiveFlags &= ~TimerBit(Num);  /* set timer as inactive */
+  }
   return ES_Timer_OK;
 }
 
@@ -221,31 +317,251 @@ ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
  Function
      ES_Timer_InitTimer
  Parameters
-     unsigned char Num, the number of the timer to start
-     unsigned int NewTime, the number of ticks to be counted
+     unsigned char Num, the number (or handle) of the timer to start
+     uint32_t NewTime, the number of ticks to be counted
  Returns
      ES_Timer_ERR if the requested timer does not exist, ES_Timer_OK otherwise.
  Description
      sets the NewTime into the chosen timer and sets the timer active to
      begin counting.
  Notes
-     None.
+     makes the timer a one-shot, if it was periodic.
  Author
      J. Edward Carryer, 02/24/97 14:51
 ****************************************************************************/
-ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime)
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint32_t NewTime)
 {
   /* tried to set a timer that doesn't exist */
-  if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
+  if ((Num >= ES_NUM_TIMERS) ||
       /* tried to set a timer without a service */
-      (Timer2PostFunc[Num] == TIMER_UNUSED) ||
+      !HasService(Num) ||
       /* tried to set a timer without putting any time on it */
       (NewTime == 0))
   {
     return ES_Timer_ERR;
   }
+  if (TMR_ActiveFlags & TimerBit(Num))
+  {
+    Unlist(Num);  // restarting a running timer
+  }
   TMR_TimerArray[Num] = NewTime;
-  TMR_ActiveFlags     |= BitNum2SetMask[Num]; /* set timer as active */
+  TimerPeriod[Num]    = 0;
+  Enlist(Num, NewTime);
+  TMR_ActiveFlags     |= TimerBit(Num); /* set timer as active */
+  return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_InitPeriodic
+ Parameters
+     unsigned char Num, the number (or handle) of the timer to start
+     uint32_t Period, the number of ticks between timeouts
+ Returns
+     ES_Timer_ERR if the requested timer does not exist, ES_Timer_OK otherwise.
+ Description
+     starts the timer so that it times out every Period ticks until it is
+     stopped. The first timeout is Period ticks from now.
+ Notes
+     The timer is re-armed by the tick response from the time it was due,
+     so there is no need to restart it in the ES_TIMEOUT handling and the
+     timeouts do not drift. If the service has not run the last ES_TIMEOUT
+     by the time the next is due, the new one is not posted but counted,
+     see ES_Timer_GetMissed.
+     ES_Timer_StopTimer and ES_Timer_StartTimer pause and resume it,
+     ES_Timer_InitTimer turns it back into a one-shot.
+ Author
+     M. Saboo, 10/16/26, 21:00
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_InitPeriodic(uint8_t Num, uint32_t Period)
+{
+  if (ES_Timer_InitTimer(Num, Period) != ES_Timer_OK)
+  {
+    return ES_Timer_ERR;
+  }
+  TimerPeriod[Num]    = Period;
+  MissedPeriods[Num]  = 0;
+  TMR_PendingFlags    &= ~TimerBit(Num);
+  return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_GetMissed
+ Parameters
+     unsigned char Num, the number (or handle) of a periodic timer
+ Returns
+     the number of periods that were not posted because the service had not
+     yet run the previous ES_TIMEOUT, since the last call
+ Description
+     lets a service catch up on the periods it missed while it was busy,
+     and clears the count
+ Notes
+     the count stops at 65535
+ Author
+     M. Saboo, 10/16/26, 21:00
+****************************************************************************/
+uint16_t ES_Timer_GetMissed(uint8_t Num)
+{
+  uint16_t Missed;
+
+  if (Num >= ES_NUM_TIMERS)
+  {
+    return 0;
+  }
+  Missed              = MissedPeriods[Num];
+  MissedPeriods[Num]  = 0;
+  return Missed;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_TimeoutDispatched
+ Parameters
+     uint16_t Num, the EventParam of an ES_TIMEOUT that is about to be run
+ Returns
+     None.
+ Description
+     marks the timer's last ES_TIMEOUT as no longer pending, so that the
+     next period is posted
+ Notes
+     called by ES_Run for every ES_TIMEOUT that it takes from a queue
+ Author
+     M. Saboo, 10/16/26, 21:00
+****************************************************************************/
+void ES_Timer_TimeoutDispatched(uint16_t Num)
+{
+  if (Num < ES_NUM_TIMERS)
+  {
+    TMR_PendingFlags &= ~TimerBit(Num);
+  }
+  ES_TIMER_STATS_DISPATCHED(Num);
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_SetCallback
+ Parameters
+     unsigned char Num, the number (or handle) of the timer
+     ES_TimerCallback_t Callback, the function to call when it expires, or
+     NULL to go back to posting ES_TIMEOUT
+ Returns
+     ES_Timer_ERR if the requested timer does not exist or has no service,
+     ES_Timer_OK otherwise
+ Description
+     makes the timer call Callback, with the timer number, from the tick
+     response when it expires, rather than posting ES_TIMEOUT to its
+     service. Start it as usual with ES_Timer_InitTimer or
+     ES_Timer_InitPeriodic.
+ Notes
+     The callback runs in the same context as the tick response, ahead of
+     any run functions, so it must be short: a few port writes, a counter
+     update or a post. One that runs for more than ES_TIMER_CALLBACK_LIMIT
+     core timer counts is dropped after that call and the timer posts
+     ES_TIMEOUT from then on, so the service should still handle it.
+     The timer still needs a service for that reason.
+ Author
+     M. Saboo, 10/16/26, 22:00
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_SetCallback(uint8_t Num, ES_TimerCallback_t Callback)
+{
+  if ((Num >= ES_NUM_TIMERS) || !HasService(Num))
+  {
+    return ES_Timer_ERR;
+  }
+  TimerCallback[Num]      = Callback;
+  CallbackMaxCounts[Num]  = 0;
+  return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_GetCallbackMax
+ Parameters
+     unsigned char Num, the number (or handle) of a callback timer
+ Returns
+     the longest that its callback has taken, in core timer counts
+ Description
+     a callback that has been dropped by the guard shows a time over
+     ES_TIMER_CALLBACK_LIMIT here
+ Author
+     M. Saboo, 10/16/26, 22:00
+****************************************************************************/
+uint32_t ES_Timer_GetCallbackMax(uint8_t Num)
+{
+  return (Num < ES_NUM_TIMERS) ? CallbackMaxCounts[Num] : 0;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_Alloc
+ Parameters
+     uint8_t WhichService, the service to post the timer's ES_TIMEOUT to
+ Returns
+     the handle of the timer, or ES_TIMER_NO_HANDLE if the pool is empty or
+     the service does not exist
+ Description
+     takes a timer from the pool and ties it to the service. The handle is
+     then used in place of a timer number with the other ES_Timer functions
+     and comes back as the EventParam of the ES_TIMEOUT.
+ Notes
+     normally called once from the service's init function. The timer is
+     stopped until it is started with ES_Timer_InitTimer.
+ Author
+     M. Saboo, 10/16/26, 20:00
+****************************************************************************/
+ES_TimerHandle_t ES_Timer_Alloc(uint8_t WhichService)
+{
+#if ES_TIMER_POOL_SIZE > 0
+  uint8_t i;
+
+  if (WhichService < NUM_SERVICES)
+  {
+    for (i = 0; i < ES_TIMER_POOL_SIZE; i++)
+    {
+      if (PoolInUse[i] == false)
+      {
+        PoolInUse[i]  = true;
+        PoolOwner[i]  = WhichService;
+        TMR_TimerArray[ES_NUM_NUMBERED_TIMERS + i] = 0;
+        return ES_NUM_NUMBERED_TIMERS + i;
+      }
+    }
+  }
+#else
+  (void)WhichService;
+#endif
+  return ES_TIMER_NO_HANDLE;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_Free
+ Parameters
+     ES_TimerHandle_t Handle, a timer from ES_Timer_Alloc
+ Returns
+     ES_Timer_ERR if the handle is not an allocated pool timer,
+     ES_Timer_OK otherwise
+ Description
+     stops the timer and returns it to the pool
+ Notes
+     an ES_TIMEOUT from the timer may still be in the service's queue
+ Author
+     M. Saboo, 10/16/26, 20:00
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_Free(ES_TimerHandle_t Handle)
+{
+  if ((Handle < ES_NUM_NUMBERED_TIMERS) || !HasService(Handle))
+  {
+    return ES_Timer_ERR;
+  }
+  ES_Timer_StopTimer(Handle);
+  TMR_TimerArray[Handle] = 0;
+  TimerPeriod[Handle]    = 0;
+  TimerCallback[Handle]  = NULL;
+#if ES_TIMER_POOL_SIZE > 0
+  PoolInUse[Handle - ES_NUM_NUMBERED_TIMERS] = false;
+#endif
   return ES_Timer_OK;
 }
 
@@ -270,6 +586,123 @@ uint16_t ES_Timer_GetTime(void)
   return _HW_GetTickCount();
 }
 
+/****************************************************************************
+ Function
+     ES_GetTime64
+ Parameters
+     None.
+ Returns
+     uint64_t the core timer counts (50nS) since reset
+ Description
+     extends the 32 bit CP0 Count register, which wraps every 214.7 seconds,
+     to a 64 bit clock that does not wrap
+ Notes
+     Safe to call from an ISR, but not from inside a critical region, since
+     it makes its own. A wrap is only caught if the Count is read at least
+     once per wrap, so ES_Timer_Advance reads it on every tick.
+ Author
+     M. Saboo, 10/17/26, 01:00
+****************************************************************************/
+uint64_t ES_GetTime64(void)
+{
+  uint32_t Count;
+  uint32_t High;
+
+  EnterCritical();
+  Count = _CP0_GET_COUNT();
+  if (Count < LastCount)
+  {
+    CountHigh++;
+  }
+  LastCount = Count;
+  High      = CountHigh;
+  ExitCritical();
+  return ((uint64_t)High << 32) | Count;
+}
+
+/****************************************************************************
+ Function
+     ES_GetTime_us
+ Parameters
+     None.
+ Returns
+     uint64_t the microseconds since reset
+ Description
+     ES_GetTime64 in uS, for time stamps that are read by people
+ Notes
+     to time an interval, take the difference of two ES_GetTime64 readings
+     and convert that, it saves a divide
+ Author
+     M. Saboo, 10/17/26, 01:00
+****************************************************************************/
+uint64_t ES_GetTime_us(void)
+{
+  return ES_Time64ToUs(ES_GetTime64());
+}
+
+/****************************************************************************
+ Function
+     ES_Time64ToUs
+ Parameters
+     uint64_t Counts, a time or interval in core timer counts
+ Returns
+     uint64_t the same time in microseconds, rounded down
+ Description
+     converts a 64 bit core timer time to uS
+ Notes
+     see DivideCounts, there is no 64 bit divide
+ Author
+     M. Saboo, 10/17/26, 01:00
+****************************************************************************/
+uint64_t ES_Time64ToUs(uint64_t Counts)
+{
+  return DivideCounts(Counts, ES_CORE_COUNTS_PER_US);
+}
+
+/****************************************************************************
+ Function
+     ES_Time64ToMs
+ Parameters
+     uint64_t Counts, a time or interval in core timer counts
+ Returns
+     uint64_t the same time in milliseconds, rounded down
+ Description
+     converts a 64 bit core timer time to mS
+ Notes
+     see DivideCounts, there is no 64 bit divide
+ Author
+     M. Saboo, 10/17/26, 01:00
+****************************************************************************/
+uint64_t ES_Time64ToMs(uint64_t Counts)
+{
+  return DivideCounts(Counts, ES_CORE_COUNTS_PER_US * 1000);
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_TicksToNextExpiry
+ Parameters
+     None.
+ Returns
+     uint32_t the number of ticks until the next timer expires, UINT32_MAX
+     if no timer is running
+ Description
+     lets the port stop the tick until it is next needed (see ES_TICKLESS)
+ Notes
+     counts from the last tick that ES_Timer_Tick_Resp has processed, so
+     the result is only good while no ticks are waiting to be processed
+ Author
+     M. Saboo, 10/16/26, 23:00
+****************************************************************************/
+uint32_t ES_Timer_TicksToNextExpiry(void)
+{
+  if (NextToExpire == NO_TIMER)
+  {
+    return UINT32_MAX;
+  }
+  return TimerLinks[NextToExpire].Deadline - TimerNow;
+}
+
 /****************************************************************************
  Function
      ES_Timer_Tick_Resp
@@ -279,46 +712,426 @@ uint16_t ES_Timer_GetTime(void)
      None.
  Description
      This is the new Tick response routine to support the timer module.
-     It will increment time, to maintain the functionality of the
-     GetTime() timer and it will check through the active timers,
-     decrementing each active timers count, if the count goes to 0, it
-     will post an event to the corresponding SM and clear the active flag to
-     prevent further counting.
+     It advances the timer time base by one tick, see ES_Timer_Advance
  Notes
-     Called from _Timer_Int_Resp in ES_Port.c.
+     kept for code that ticks the timers itself, the ports use
+     ES_Timer_Advance
  Author
      J. Edward Carryer, 02/24/97 15:06
 ****************************************************************************/
 void ES_Timer_Tick_Resp(void)
 {
-  static Tflag_t  NeedsProcessing;
+  ES_Timer_Advance(1);
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_Advance
+ Parameters
+     uint32_t Ticks, the number of ticks that have passed
+ Returns
+     None.
+ Description
+     Advances the timer time base by Ticks and expires every timer whose
+     deadline has been reached, in deadline order. Each expiry posts an
+     event to the corresponding SM, clears the active flag and takes the
+     timer off the list. A periodic timer is put back into the list one
+     period after its deadline instead, and a callback timer calls its
+     callback rather than posting.
+ Notes
+     Called from _HW_Process_Pending_Ints in ES_Port.c with all of the
+     ticks that have occurred since it last ran, so a catch-up after ints
+     were off costs one pass for the timers that expire rather than one
+     tick response per tick.
+     Each timer is expired with the time base at its own deadline, so a
+     periodic timer that falls more than a period behind expires again in
+     the same pass and counts the missed periods. A timer (re)started by a
+     callback is timed from the deadline of the timer that called it.
+     Timers that expire on the same tick are posted highest number first,
+     the same order as the old walk of the active flags.
+ Author
+     M. Saboo, 10/17/26, 00:00
+****************************************************************************/
+void ES_Timer_Advance(uint32_t Ticks)
+{
   static uint8_t  NextTimer2Process;
-  static ES_Event_t NewEvent;
+  uint32_t        NewNow = TimerNow + Ticks;
+
+  // keep the 64 bit clock from missing a wrap of the Count
+  ES_GetTime64();
+  ES_TIMER_STATS_ADVANCE(Ticks);
+
+  // compare distances from TimerNow rather than the deadlines themselves,
+  // so the wrap of the time base does not matter
+  while ((NextToExpire != NO_TIMER) &&
+      ((TimerLinks[NextToExpire].Deadline - TimerNow) <= (NewNow - TimerNow)))
+  {
+    NextTimer2Process = NextToExpire;
+    TimerNow = TimerLinks[NextTimer2Process].Deadline;
+    /* stop counting before the post, in case the service restarts it */
+    Unlist(NextTimer2Process);
+    if (TimerPeriod[NextTimer2Process] == 0)
+    {
+      TMR_TimerArray[NextTimer2Process] = 0;
+      TMR_ActiveFlags &= ~TimerBit(NextTimer2Process);
+      if (TimerCallback[NextTimer2Process] != NULL)
+      {
+        RunCallback(NextTimer2Process);
+      }
+      else if (PostTimeout(NextTimer2Process))
+      {
+        ES_TIMER_STATS_EXPIRED(NextTimer2Process, ExpiryCount(NewNow));
+      }
+    }
+    else
+    {
+      // due again one period after this deadline, which is TimerNow
+      Enlist(NextTimer2Process, TimerPeriod[NextTimer2Process]);
+      if (TimerCallback[NextTimer2Process] != NULL)
+      {
+        RunCallback(NextTimer2Process);
+      }
+      else if (((TMR_PendingFlags & TimerBit(NextTimer2Process)) == 0) &&
+          PostTimeout(NextTimer2Process))
+      {
+        TMR_PendingFlags |= TimerBit(NextTimer2Process);
+        ES_TIMER_STATS_EXPIRED(NextTimer2Process, ExpiryCount(NewNow));
+      }
+      else if (MissedPeriods[NextTimer2Process] != UINT16_MAX)
+      {
+        MissedPeriods[NextTimer2Process]++;
+      }
+    }
+  }
+  TimerNow = NewNow;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+     Enlist
+ Parameters
+     uint8_t Num, the timer to add to the active list
+     Timer_t Ticks, how many ticks from now it should expire
+ Returns
+     None.
+ Description
+     inserts the timer into the active list, behind every timer that
+     expires before it and every higher numbered timer that expires on the
+     same tick
+ Notes
+     the timer must not already be in the list
+ Author
+     M. Saboo, 10/16/26, 19:00
+****************************************************************************/
+static void Enlist(uint8_t Num, Timer_t Ticks)
+{
+  uint32_t  Deadline = TimerNow + Ticks;
+  uint8_t   Prev = NO_TIMER;
+  uint8_t   Next = NextToExpire;
+
+  // every deadline is less than 2^32 ticks after TimerNow, so comparing
+  // the time left, rather than the deadlines, is safe across the wrap
+  while ((Next != NO_TIMER) &&
+      (((TimerLinks[Next].Deadline - TimerNow) < Ticks) ||
+      (((TimerLinks[Next].Deadline - TimerNow) == Ticks) && (Next > Num))))
+  {
+    Prev  = Next;
+    Next  = TimerLinks[Next].Next;
+  }
+  TimerLinks[Num].Deadline  = Deadline;
+  TimerLinks[Num].Prev      = Prev;
+  TimerLinks[Num].Next      = Next;
+  if (Prev == NO_TIMER)
+  {
+    NextToExpire = Num;
+  }
+  else
+  {
+    TimerLinks[Prev].Next = Num;
+  }
+  if (Next != NO_TIMER)
+  {
+    TimerLinks[Next].Prev = Num;
+  }
+}
+
+/****************************************************************************
+ Function
+     Unlist
+ Parameters
+     uint8_t Num, the timer to take out of the active list
+ Returns
+     None.
+ Description
+     unlinks the timer from its neighbours in the active list
+ Notes
+     the timer must be in the list
+ Author
+     M. Saboo, 10/16/26, 19:00
+****************************************************************************/
+static void Unlist(uint8_t Num)
+{
+  uint8_t Prev = TimerLinks[Num].Prev;
+  uint8_t Next = TimerLinks[Num].Next;
+
+  if (Prev == NO_TIMER)
+  {
+    NextToExpire = Next;
+  }
+  else
+  {
+    TimerLinks[Prev].Next = Next;
+  }
+  if (Next != NO_TIMER)
+  {
+    TimerLinks[Next].Prev = Prev;
+  }
+}
+
+/****************************************************************************
+ Function
+     PostTimeout
+ Parameters
+     uint8_t Num, the number (or handle) of the timer that expired
+ Returns
+     false if the post failed
+ Description
+     posts ES_TIMEOUT, with the timer number as the parameter, to the
+     timer's service
+ Author
+     M. Saboo, 10/16/26, 21:00
+****************************************************************************/
+static bool PostTimeout(uint8_t Num)
+{
+  ES_Event_t  NewEvent;
+  bool        IsPosted = false;
+
+  NewEvent.EventType  = ES_TIMEOUT;
+  NewEvent.EventParam = Num;
+  ES_TRACE_EVENT(ES_TRACE_TIMEOUT, Num, NewEvent);
+  /* post the timeout event to the right Service */
+  if (Num < ES_NUM_NUMBERED_TIMERS)
+  {
+    IsPosted = Timer2PostFunc[Num](NewEvent);
+  }
+#if ES_TIMER_POOL_SIZE > 0
+  else
+  {
+    IsPosted = ES_PostToService(PoolOwner[Num - ES_NUM_NUMBERED_TIMERS],
+        NewEvent);
+  }
+#endif
+  return IsPosted;
+}
+
+/****************************************************************************
+ Function
+     RunCallback
+ Parameters
+     uint8_t Num, the number (or handle) of the callback timer that expired
+ Returns
+     None.
+ Description
+     calls the timer's callback and times it. A callback that ran for more
+     than ES_TIMER_CALLBACK_LIMIT is dropped, so the next expiry posts.
+ Author
+     M. Saboo, 10/16/26, 22:00
+****************************************************************************/
+static void RunCallback(uint8_t Num)
+{
+  uint32_t StartTime;
+  uint32_t Counts;
+
+  ES_TRACE_EVENT(ES_TRACE_TIMEOUT, Num, ((ES_Event_t){ ES_TIMEOUT, Num }));
+  StartTime = _CP0_GET_COUNT();
+  TimerCallback[Num](Num);
+  Counts = _CP0_GET_COUNT() - StartTime;
+  if (Counts > CallbackMaxCounts[Num])
+  {
+    CallbackMaxCounts[Num] = Counts;
+  }
+  if (Counts > ES_TIMER_CALLBACK_LIMIT)
+  {
+    TimerCallback[Num] = NULL;
+  }
+}
+
+/****************************************************************************
+ Function
+     ExpiryCount
+ Parameters
+     uint32_t NewNow, the tick that ES_Timer_Advance is moving the time base
+     to
+ Returns
+     uint32_t the core count that the timer expiring now was due at
+ Description
+     counts back from the last tick handed to ES_Timer_Advance to the
+     deadline being expired, TimerNow, so that the timer statistics see
+     the time the tick waited for ES_Run and any catch-up as lateness
+ Notes
+     only used through ES_TIMER_STATS_EXPIRED
+ Author
+     M. Saboo, 10/17/26, 11:20
+****************************************************************************/
+static inline uint32_t ExpiryCount(uint32_t NewNow)
+{
+  return _HW_GetLastTickCount() - ((NewNow - TimerNow) * TickCounts);
+}
+
+/****************************************************************************
+ Function
+     DivideCounts
+ Parameters
+     uint64_t Counts, the time to divide
+     uint32_t Divisor, what to divide it by, not 0 or 1
+ Returns
+     uint64_t Counts / Divisor, rounded down
+ Description
+     divides a 64 bit time using only 32 bit divides
+ Notes
+     A 64 bit divide is a slow library call on the PIC32, while a 32 bit
+     divide by a constant is a multiply. With 2^32 = Divisor * Quot32 +
+     Rem32 and Counts = High * 2^32 + Low, the result is
+       (High / Divisor) * 2^32
+       + (High % Divisor) * Quot32 + Low / Divisor
+       + ((High % Divisor) * Rem32 + Low % Divisor) / Divisor
+     and every term fits in 32 bits for the divisors used here (up to 65536)
+ Author
+     M. Saboo, 10/17/26, 01:00
+****************************************************************************/
+static uint64_t DivideCounts(uint64_t Counts, uint32_t Divisor)
+{
+  uint32_t High     = (uint32_t)(Counts >> 32);
+  uint32_t Low      = (uint32_t)Counts;
+  uint32_t HighRem  = High % Divisor;
+  // 2^32 / Divisor and 2^32 % Divisor, without 2^32
+  uint32_t Quot32   = UINT32_MAX / Divisor;
+  uint32_t Rem32    = (UINT32_MAX % Divisor) + 1;
 
-  if (TMR_ActiveFlags != 0) /* if !=0 , then at least 1 timer is active */
+  if (Rem32 == Divisor)
+  {
+    Quot32++;
+    Rem32 = 0;
+  }
+  return ((uint64_t)(High / Divisor) << 32) +
+         ((HighRem * Quot32) + (Low / Divisor) +
+         (((HighRem * Rem32) + (Low % Divisor)) / Divisor));
+}
+
+/****************************************************************************
+ Function
+     HasService
+ Parameters
+     uint8_t Num, the number (or handle) of the timer
+ Returns
+     true if the timer exists and has a service to post its timeout to
+ Author
+     M. Saboo, 10/16/26, 20:00
+****************************************************************************/
+static bool HasService(uint8_t Num)
+{
+  if (Num < ES_NUM_NUMBERED_TIMERS)
+  {
+    return Timer2PostFunc[Num] != TIMER_UNUSED;
+  }
+#if ES_TIMER_POOL_SIZE > 0
+  if (Num < ES_NUM_TIMERS)
   {
-    // start by getting a list of all the active timers
-    NeedsProcessing = TMR_ActiveFlags;
+    return PoolInUse[Num - ES_NUM_NUMBERED_TIMERS];
+  }
+#endif
+  return false;
+}
+
+#ifdef TIMER_BENCH
+/* Compares the cost of a tick with the deadline list against the old walk
+   that decremented every active timer, with every configured timer running.
+   Times are in core timer counts (2 SYSCLKs on the PIC32, 50nS on the host
+   port) per BENCH_TICKS ticks, none of which expire a timer. The last line
+   is the same ticks caught up in a single ES_Timer_Advance. Build with
+   ES_Port.c and terminal.c for the console. */
+#include <stdio.h>
+#include "terminal.h"
+
+#define BENCH_TICKS 1000
+
+static uint16_t OldTimerArray[ES_NUM_NUMBERED_TIMERS];
+static uint16_t OldActiveFlags;
+
+// the tick response as it was before the deadline list
+static void OldTickResp(void)
+{
+  uint16_t  NeedsProcessing;
+  uint8_t NextTimer2Process;
+
+  if (OldActiveFlags != 0)
+  {
+    NeedsProcessing = OldActiveFlags;
     do
     {
-      // find the MSB that is set
       NextTimer2Process = ES_GetMSBitSet(NeedsProcessing);
-      /* decrement that timer, check if timed out */
-      if (--TMR_TimerArray[NextTimer2Process] == 0)
+      if (--OldTimerArray[NextTimer2Process] == 0)
       {
-        NewEvent.EventType  = ES_TIMEOUT;
-        NewEvent.EventParam = NextTimer2Process;
-        /* post the timeout event to the right Service */
-        Timer2PostFunc[NextTimer2Process](NewEvent);
-        /* and stop counting */
-        TMR_ActiveFlags &= BitNum2ClrMask[NextTimer2Process];
+        OldActiveFlags &= BitNum2ClrMask[NextTimer2Process];
       }
-      // mark off the active timer that we just processed
       NeedsProcessing &= BitNum2ClrMask[NextTimer2Process];
     } while (NeedsProcessing != 0);
   }
 }
 
+void main(void)
+{
+  uint16_t  Tick;
+  uint8_t   Num;
+  uint8_t   NumRunning = 0;
+  uint32_t  StartTime;
+  uint32_t  OldTime;
+  uint32_t  NewTime;
+  uint32_t  BatchTime;
+
+  _HW_PIC32Init();
+  puts("\rTimer tick benchmark\r");
+  for (Num = 0; Num < ES_NUM_NUMBERED_TIMERS; Num++)
+  {
+    // spread the deadlines out, all beyond the end of the run
+    if (ES_Timer_InitTimer(Num, 60000 - Num) == ES_Timer_OK)
+    {
+      OldTimerArray[Num] = 60000 - Num;
+      OldActiveFlags |= BitNum2SetMask[Num];
+      NumRunning++;
+    }
+  }
+
+  StartTime = _CP0_GET_COUNT();
+  for (Tick = 0; Tick < BENCH_TICKS; Tick++)
+  {
+    OldTickResp();
+  }
+  OldTime = _CP0_GET_COUNT() - StartTime;
+
+  StartTime = _CP0_GET_COUNT();
+  for (Tick = 0; Tick < BENCH_TICKS; Tick++)
+  {
+    ES_Timer_Tick_Resp();
+  }
+  NewTime = _CP0_GET_COUNT() - StartTime;
+
+  StartTime = _CP0_GET_COUNT();
+  ES_Timer_Advance(BENCH_TICKS);
+  BatchTime = _CP0_GET_COUNT() - StartTime;
+
+  printf("%u timers running, %u ticks\r\n", NumRunning, BENCH_TICKS);
+  printf("decrement walk: %lu counts\r\n", (unsigned long)OldTime);
+  printf("deadline list : %lu counts\r\n", (unsigned long)NewTime);
+  printf("one advance   : %lu counts\r\n", (unsigned long)BatchTime);
+  while (1)
+  {
+    Terminal_MoveBuffer2UART(); // printf only fills the transmit buffer
+  }
+}
+#endif
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
-
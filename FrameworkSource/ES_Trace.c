@@ -0,0 +1,220 @@
+/****************************************************************************
+ Module
+     ES_Trace.c
+ Description
+     Optional binary trace of framework activity. Each post, dequeue, run
+     function entry/exit and timer timeout is recorded with a core timer
+     time stamp in a ring buffer in RAM. ES_Run drains the buffer to the
+     UART in the background, while it has nothing else to do.
+ Notes
+     Only compiled when ES_TRACE is defined in ES_Configure.h.
+     Each record goes out as an 11 byte frame:
+       0     0xA5 (sync)
+       1     kind (ES_TraceKind_t)
+       2     service (timer number for ES_TRACE_TIMEOUT)
+       3     event type
+       4-5   event parameter, LS byte first
+       6-9   core timer count (50nS), LS byte first
+       10    checksum, ~(sum of bytes 1 to 9)
+     The frames are mixed in with any printf output on the same UART, the
+     decoder (Tools/es_trace_decode.py) finds them by the sync byte and the
+     checksum and passes everything else through as text.
+     Frames are only started when the transmit buffer is empty, so they are
+     never split by text that was already waiting to go out.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 10:00 mss      send the overflow frame where the records were lost
+ 10/16/26 17:00 mss      started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_General.h"
+#include "ES_Port.h"
+#include "ES_Trace.h"
+#include "terminal.h"
+
+#ifdef ES_TRACE
+
+/*----------------------------- Module Defines ----------------------------*/
+#define TRACE_SYNC 0xA5
+// how many frames to send each time that ES_Run is idle, 8 frames is about
+// 8mS of UART time at 115200 baud
+#define FRAMES_PER_DRAIN 8
+
+#if (ES_TRACE_SIZE & (ES_TRACE_SIZE - 1)) || (ES_TRACE_SIZE > 32768)
+#error "ES_TRACE_SIZE must be a power of 2, no more than 32768"
+#endif
+
+/*------------------------------ Module Types -----------------------------*/
+typedef struct
+{
+  uint32_t  Time;
+  uint16_t  EventParam;
+  uint8_t   Kind;
+  uint8_t   Service;
+  uint8_t   EventType;
+}TraceRecord_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void SendFrame(TraceRecord_t const *pRecord);
+
+/*---------------------------- Module Variables ---------------------------*/
+static TraceRecord_t  TraceBuffer[ES_TRACE_SIZE];
+// free running indices, the buffer holds (TraceHead - TraceTail) records
+static uint16_t       TraceHead;
+static uint16_t       TraceTail;
+// records lost since the last ES_TRACE_OVERFLOW frame, and the value of
+// TraceHead when the first of them was lost, where the frame goes in sequence
+static uint16_t       NumDropped;
+static uint16_t       DropHead;
+// the time stamp of the last record sent, for the ES_TRACE_OVERFLOW frame
+static uint32_t       LastSentTime;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Trace_Record
+ Parameters
+   ES_TraceKind_t : what happened
+   uint8_t : Which service it happened to (timer number for timeouts)
+   ES_Event_t : the event involved
+ Returns
+   nothing
+ Description
+   adds a time stamped record to the trace buffer, or counts it as lost if
+   the buffer is full
+ Notes
+   may be called from an ISR, the slot is claimed and filled with ints off
+ Author
+   M. Saboo, 10/16/26, 17:00
+****************************************************************************/
+void ES_Trace_Record(ES_TraceKind_t Kind, uint8_t WhichService,
+    ES_Event_t TheEvent)
+{
+  TraceRecord_t *pRecord;
+  uint32_t      Now = _CP0_GET_COUNT();
+
+  EnterCritical();
+  if ((uint16_t)(TraceHead - TraceTail) < ES_TRACE_SIZE)
+  {
+    pRecord             = &TraceBuffer[TraceHead & (ES_TRACE_SIZE - 1)];
+    pRecord->Time       = Now;
+    pRecord->EventParam = TheEvent.EventParam;
+    pRecord->Kind       = (uint8_t)Kind;
+    pRecord->Service    = WhichService;
+    pRecord->EventType  = (uint8_t)TheEvent.EventType;
+    TraceHead++;
+  }
+  else if (NumDropped == 0)
+  {
+    DropHead    = TraceHead;
+    NumDropped  = 1;
+  }
+  else if (NumDropped != UINT16_MAX)
+  {
+    NumDropped++;
+  }
+  ExitCritical();
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Drain
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   sends up to FRAMES_PER_DRAIN records to the terminal
+ Notes
+   called from ES_Run when there is nothing else to do
+ Author
+   M. Saboo, 10/16/26, 17:00
+****************************************************************************/
+void ES_Trace_Drain(void)
+{
+  TraceRecord_t Record;
+  uint8_t       NumSent;
+
+  if (!Terminal_IsTxEmpty())
+  {
+    return;   // let the text (or our last frames) go out first
+  }
+  for (NumSent = 0; NumSent < FRAMES_PER_DRAIN; NumSent++)
+  {
+    EnterCritical();
+    if ((NumDropped != 0) && (TraceTail == DropHead))
+    {
+      // the records before the loss have all gone out, so report it here,
+      // in sequence. It has no time of its own, so it takes the time of the
+      // last record sent, which keeps the decoder's timeline running forward
+      Record.Time       = LastSentTime;
+      Record.EventParam = NumDropped;
+      Record.Kind       = ES_TRACE_OVERFLOW;
+      Record.Service    = 0;
+      Record.EventType  = ES_NO_EVENT;
+      NumDropped        = 0;
+    }
+    else if (TraceHead != TraceTail)
+    {
+      Record = TraceBuffer[TraceTail & (ES_TRACE_SIZE - 1)];
+      TraceTail++;
+    }
+    else
+    {
+      ExitCritical();
+      break;  // nothing left to send
+    }
+    ExitCritical();
+    LastSentTime = Record.Time;
+    SendFrame(&Record);
+  }
+  Terminal_MoveBuffer2UART();
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   SendFrame
+ Parameters
+   TraceRecord_t const * : the record to send
+ Returns
+   nothing
+ Description
+   writes the record to the terminal as a frame, see the notes at the top
+ Author
+   M. Saboo, 10/16/26, 17:00
+****************************************************************************/
+static void SendFrame(TraceRecord_t const *pRecord)
+{
+  uint8_t Frame[11];
+  uint8_t Sum = 0;
+  uint8_t i;
+
+  Frame[0]  = TRACE_SYNC;
+  Frame[1]  = pRecord->Kind;
+  Frame[2]  = pRecord->Service;
+  Frame[3]  = pRecord->EventType;
+  Frame[4]  = (uint8_t)pRecord->EventParam;
+  Frame[5]  = (uint8_t)(pRecord->EventParam >> 8);
+  Frame[6]  = (uint8_t)pRecord->Time;
+  Frame[7]  = (uint8_t)(pRecord->Time >> 8);
+  Frame[8]  = (uint8_t)(pRecord->Time >> 16);
+  Frame[9]  = (uint8_t)(pRecord->Time >> 24);
+  for (i = 1; i < 10; i++)
+  {
+    Sum += Frame[i];
+  }
+  Frame[10] = (uint8_t)~Sum;
+  for (i = 0; i < ARRAY_SIZE(Frame); i++)
+  {
+    Terminal_WriteByte(Frame[i]);
+  }
+}
+
+#endif /* ES_TRACE */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -11,22 +11,32 @@
   emulator through a UART-USB bridge interface.
  Notes
   For the PIC32 port, we are using UART 1
+  With ES_TERMINAL_RX_CHECKER defined in ES_Configure.h, the receive
+  interrupt wakes that event checker when a byte arrives. The flag stays
+  set for as long as there is a byte waiting, so the interrupt turns
+  itself off and reading the byte turns it back on.
 
  History
  When           Who     What/Why
  -------------- ---     --------
  08/29/20 14:46 ram     first pass
  10/05/20 19:38 ram     starting work on PIC32 port
+ 10/16/26 16:00 mss     added Terminal_IsTxEmpty
+ 10/17/26 11:00 mss     added Terminal_Flush
+ 10/17/26 11:10 mss     the receive interrupt wakes ES_TERMINAL_RX_CHECKER
  ***************************************************************************/
 
 /*----------------------------- Include Files -----------------------------*/
 
 // Hardware
 #include <xc.h>
+#include <sys/attribs.h>    // for ISR macros
 #include <stdio.h>
 
+#include "ES_Configure.h"
 #include "ES_General.h"
 #include "ES_Port.h"
+#include "ES_CheckEvents.h"
 #include "circular_buffer.h"
 #include "dbprintf.h"
 
@@ -36,10 +46,15 @@
 #define BAUD_CONST 42 // sets up baud rate for 115200
 //#define BAUD_CONST 21 // sets up baud rate for 230400
 
+// interrupt priority of the receive interrupt, must match the IPL in the
+// __ISR() below. The lowest, since all it does is wake a checker
+#define RX_PRIORITY 1
+
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this service.They should be functions
    relevant to the behavior of this service
 */
+static void RearmRxInt(void);
 
 /*---------------------------- Module Variables ---------------------------*/
 static uint8_t xmitBuffer[XMIT_BUFFER_SIZE];
@@ -100,6 +115,13 @@ void Terminal_HWInit(void)
   U1STAbits.UTXEN = 1; // enable transmit 
   U1STAbits.URXEN = 1; // enable receive
   U1MODEbits.ON = 1; // turn peripheral on
+
+#ifdef ES_TERMINAL_RX_CHECKER
+  // interrupt whenever there is a byte waiting (URXISEL = 0)
+  IEC1CLR = _IEC1_U1RXIE_MASK;
+  IPC8bits.U1IP = RX_PRIORITY;
+  RearmRxInt();
+#endif
   
   // now initialize the circular buffer for transmitting
   xmitBufferHandle = circular_buf_init( xmitBuffer, ARRAY_SIZE(xmitBuffer) );
@@ -116,13 +138,17 @@ void Terminal_HWInit(void)
  ******************************************************************************/
 uint8_t Terminal_ReadByte(void)
 {
+  uint8_t RxByte;
+
   // wait for there to be something
   while(!(U1STAbits.URXDA))
   {}
   // if there was an overrun, clear it to reset the unit
   if(U1STAbits.OERR) U1STAbits.OERR = 0;
-  // return the content of the receive register
-  return U1RXREG;
+  // take the content of the receive register
+  RxByte = U1RXREG;
+  RearmRxInt();
+  return RxByte;
 }
 /*******************************************************************************
  * Function: Terminal_Write
@@ -159,6 +185,7 @@ bool Terminal_IsRxData(void)
   
     if(U1STAbits.FERR != 0 ){
         U1RXREG; // in case of a framing error, read the data reg to clear err
+        RearmRxInt();
         return false;
     }
     // Return Rx Data bit from status register
@@ -201,6 +228,39 @@ void Terminal_MoveBuffer2UART( void )
   }
 }
 
+/*******************************************************************************
+ * Function: Terminal_IsTxEmpty
+ * Arguments: none
+ * Returns status
+ *
+ * Created by: M. Saboo
+ * Description: Returns true if every byte in the circular buffer has been
+ *              moved to the UART, or false if some are still waiting
+ ******************************************************************************/
+bool Terminal_IsTxEmpty( void )
+{
+  return circular_buf_empty(xmitBufferHandle);
+}
+
+/*******************************************************************************
+ * Function: Terminal_Flush
+ * Arguments: none
+ * Returns none
+ *
+ * Created by: M. Saboo
+ * Description: moves the circular buffer into the UART until it is empty, so
+ *              that a long report never overflows the buffer. Waits on the
+ *              UART, so only for use outside of the normal run of the
+ *              framework
+ ******************************************************************************/
+void Terminal_Flush( void )
+{
+  do
+  {
+    Terminal_MoveBuffer2UART();
+  } while (!Terminal_IsTxEmpty());
+}
+
 void __attribute__((noreturn)) _fassert(int nLineNumber,
                                         const char * sFileName,
                                         const char * sFailedExpression,
@@ -214,9 +274,45 @@ void __attribute__((noreturn)) _fassert(int nLineNumber,
         Terminal_MoveBuffer2UART();
     }
 }
+/*******************************************************************************
+ * Function: TerminalRxISR
+ * Arguments: none
+ * Returns none
+ *
+ * Created by: M. Saboo
+ * Description: the UART1 receive interrupt response, wakes the key checker.
+ *              The flag can not be cleared while the byte is waiting, so
+ *              the interrupt is turned off until the byte has been read
+ ******************************************************************************/
+#ifdef ES_TERMINAL_RX_CHECKER
+void __ISR(_UART_1_VECTOR, IPL1AUTO) TerminalRxISR(void)
+{
+  IEC1CLR = _IEC1_U1RXIE_MASK;
+  ES_CheckerWake(ES_TERMINAL_RX_CHECKER);
+}
+#endif
+
 /***************************************************************************
  private functions
  ***************************************************************************/
+/*******************************************************************************
+ * Function: RearmRxInt
+ * Arguments: none
+ * Returns none
+ *
+ * Created by: M. Saboo
+ * Description: clears the receive flag and turns the receive interrupt back
+ *              on. If another byte is already waiting, the flag sets again
+ *              right away, so it is not lost
+ ******************************************************************************/
+static void RearmRxInt(void)
+{
+#ifdef ES_TERMINAL_RX_CHECKER
+  IFS1CLR = _IFS1_U1RXIF_MASK;
+  IEC1SET = _IEC1_U1RXIE_MASK;
+#endif
+}
+
 // module test harness:
 #ifdef TEST
 int main(void)
@@ -0,0 +1,202 @@
+/****************************************************************************
+ Module
+   terminal_Host.c
+
+ Revision
+   1.0.1
+
+ Description
+  Linux host stand-in for terminal.c. Keystrokes come from stdin and output
+  goes to stdout.
+ Notes
+  Built in place of terminal.c when using the ES_HOST_PORT configuration.
+  stdin is put in non-canonical mode so that keys arrive one at a time
+  without waiting for Enter, just as they do over the UART. stdout is fully
+  buffered and Terminal_MoveBuffer2UART flushes it, the equivalent of the
+  circular buffer that terminal.c drains into the UART.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 11:10 mss     added Terminal_HostPoll, the stand-in for the
+                        receive interrupt that wakes ES_TERMINAL_RX_CHECKER
+ 10/17/26 11:00 mss     added Terminal_Flush
+ 10/16/26 16:00 mss     added Terminal_IsTxEmpty
+ 10/16/26 09:12 mss     first pass, derived from terminal.c
+ ***************************************************************************/
+
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+#include "ES_Configure.h"
+#include "ES_General.h"
+#include "ES_Port.h"
+#include "ES_CheckEvents.h"
+
+//this module
+#include "terminal.h"
+/*----------------------------- Module Defines ----------------------------*/
+
+/*---------------------------- Module Functions ---------------------------*/
+static void RestoreTerminal(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static char xmitBuffer[XMIT_BUFFER_SIZE];
+static struct termios SavedTermios;
+static bool IsTermiosSaved = false;
+// set once stdin reaches end of file so that a piped input does not look
+// like an endless stream of keys
+static bool IsStdinClosed = false;
+
+/*------------------------------ Module Code ------------------------------*/
+/*******************************************************************************
+ * Function: Terminal_HWInit
+ * Arguments: None
+ * Returns nothing
+ *
+ * Description: Puts stdin into non-canonical, no echo mode and sets up the
+ *              buffering on stdout
+ ******************************************************************************/
+void Terminal_HWInit(void)
+{
+  struct termios RawTermios;
+
+  // only bother with the terminal modes if stdin is a tty, this lets the
+  // host build be driven from a pipe or a file
+  if ((IsTermiosSaved == false) && isatty(STDIN_FILENO) &&
+      (tcgetattr(STDIN_FILENO, &SavedTermios) == 0))
+  {
+    IsTermiosSaved  = true;
+    RawTermios      = SavedTermios;
+    RawTermios.c_lflag &= ~(ICANON | ECHO);
+    RawTermios.c_cc[VMIN]   = 1;
+    RawTermios.c_cc[VTIME]  = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &RawTermios);
+    atexit(RestoreTerminal);
+  }
+  setvbuf(stdout, xmitBuffer, _IOFBF, ARRAY_SIZE(xmitBuffer));
+  return;
+}
+
+/*******************************************************************************
+ * Function: Terminal_ReadByte
+ * Arguments: None
+ * Returns byte
+ *
+ * Description: Read the next byte from stdin, blocking until there is one
+ ******************************************************************************/
+uint8_t Terminal_ReadByte(void)
+{
+  uint8_t RxByte = 0;
+
+  if (read(STDIN_FILENO, &RxByte, 1) != 1)
+  {
+    RxByte        = 0;
+    IsStdinClosed = true;
+  }
+  return RxByte;
+}
+
+/*******************************************************************************
+ * Function: Terminal_WriteByte
+ * Arguments: byte to write
+ * Returns nothing
+ *
+ * Description: Writes the byte to the stdout buffer
+ ******************************************************************************/
+void Terminal_WriteByte(uint8_t txByte)
+{
+  putchar(txByte);
+  return;
+}
+
+/*******************************************************************************
+ * Function: Terminal_IsRxData
+ * Arguments: none
+ * Returns status
+ *
+ * Description: Returns true if there is a byte waiting on stdin, or false
+ *              if not
+ ******************************************************************************/
+bool Terminal_IsRxData(void)
+{
+  struct pollfd StdinPoll = { STDIN_FILENO, POLLIN, 0 };
+
+  if (IsStdinClosed)
+  {
+    return false;
+  }
+  return (poll(&StdinPoll, 1, 0) > 0) && (StdinPoll.revents & POLLIN);
+}
+
+/*******************************************************************************
+ * Function: Terminal_MoveBuffer2UART
+ * Arguments: none
+ * Returns none
+ *
+ * Description: flushes any buffered output to stdout
+ ******************************************************************************/
+void Terminal_MoveBuffer2UART( void )
+{
+  fflush(stdout);
+}
+
+/*******************************************************************************
+ * Function: Terminal_IsTxEmpty
+ * Arguments: none
+ * Returns status
+ *
+ * Description: Always true, since Terminal_MoveBuffer2UART flushes all of
+ *              stdout
+ ******************************************************************************/
+bool Terminal_IsTxEmpty( void )
+{
+  return true;
+}
+
+/*******************************************************************************
+ * Function: Terminal_Flush
+ * Arguments: none
+ * Returns none
+ *
+ * Description: flushes all of the buffered output to stdout
+ ******************************************************************************/
+void Terminal_Flush( void )
+{
+  Terminal_MoveBuffer2UART();
+}
+
+/*******************************************************************************
+ * Function: Terminal_HostPoll
+ * Arguments: none
+ * Returns none
+ *
+ * Description: wakes ES_TERMINAL_RX_CHECKER if there is a byte waiting on
+ *              stdin, the stand-in for the UART receive interrupt. Like the
+ *              interrupt flag, it keeps waking the checker until the byte
+ *              has been read
+ ******************************************************************************/
+void Terminal_HostPoll( void )
+{
+#ifdef ES_TERMINAL_RX_CHECKER
+  if (Terminal_IsRxData())
+  {
+    ES_CheckerWake(ES_TERMINAL_RX_CHECKER);
+  }
+#endif
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void RestoreTerminal(void)
+{
+  fflush(stdout);
+  tcsetattr(STDIN_FILENO, TCSANOW, &SavedTermios);
+}
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -31,7 +31,6 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent);
 uint16_t GetAngleDeg(void);
 
 //Event Checkers
-bool CheckEncoderEvents(void);
 bool CheckCountLimits(void);
 
 #endif /* DCMotorService_H */
@@ -0,0 +1,51 @@
+/****************************************************************************
+ Module
+     FixedPoint.h
+ Description
+     header file for the Q15 & Q16.16 fixed point math library
+ Notes
+     See FixedPoint.c
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 09:00 mss      started coding
+*****************************************************************************/
+#ifndef FixedPoint_H
+#define FixedPoint_H
+
+#include <stdint.h>
+
+// Q15: a sign and 15 fraction bits, -1 to just under 1
+typedef int16_t q15_t;
+// Q16.16: a sign, 15 integer bits and 16 fraction bits, -32768 to just
+// under 32768
+typedef int32_t q16_t;
+
+#define Q15_SHIFT 15
+#define Q15_MAX ((q15_t)INT16_MAX)
+#define Q15_MIN ((q15_t)INT16_MIN)
+
+#define Q16_SHIFT 16
+#define Q16_ONE ((q16_t)1 << Q16_SHIFT)
+#define Q16_MAX ((q16_t)INT32_MAX)
+#define Q16_MIN ((q16_t)INT32_MIN)
+
+// for constants only, the conversion is done by the compiler. x must be in
+// range, Q15(1.0) does not fit
+#define Q15(x) ((q15_t)((x) * (1 << Q15_SHIFT) + (((x) < 0) ? -0.5 : 0.5)))
+#define Q16(x) ((q16_t)((x) * Q16_ONE + (((x) < 0) ? -0.5 : 0.5)))
+
+// a whole number in Q16.16, n must be in range
+#define Q16_FROM_INT(n) ((q16_t)(n) * Q16_ONE)
+
+q15_t Q15_AddSat(q15_t a, q15_t b);
+q15_t Q15_MulSat(q15_t a, q15_t b);
+q16_t Q16_AddSat(q16_t a, q16_t b);
+q16_t Q16_SubSat(q16_t a, q16_t b);
+q16_t Q16_MulSat(q16_t a, q16_t b);
+int32_t Q16_ToInt(q16_t a);
+int32_t FixedPoint_Clamp(int32_t x, int32_t Low, int32_t High);
+int32_t FixedPoint_Map(int32_t x, int32_t InLow, int32_t InHigh,
+    int32_t OutLow, int32_t OutHigh);
+
+#endif /* FixedPoint_H */
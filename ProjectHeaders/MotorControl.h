@@ -0,0 +1,39 @@
+/****************************************************************************
+ Module
+     MotorControl.h
+ Description
+     header file for the closed loop speed control of the DC motor
+ Notes
+     See MotorControl.c
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 08:00 mss      added MoveTo, for position control
+ 10/17/26 07:00 mss      started coding
+*****************************************************************************/
+#ifndef MotorControl_H
+#define MotorControl_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the rate of the control loop, and of the encoder velocity windows
+#define MOTOR_CONTROL_HZ 100
+
+// the function that the loop drives the motor through, with a duty from
+// -100 to 100 percent, positive to turn CCW (the direction that the
+// encoder counts up)
+typedef void MotorDriveFunc_t(int8_t SignedDuty);
+// the function called when a move is done, from the loop's interrupt
+typedef void MotorNotifyFunc_t(void);
+
+bool MotorControl_Init(MotorDriveFunc_t *DriveFunc);
+void MotorControl_SetSpeed(int32_t Setpoint);
+void MotorControl_Release(void);
+bool MotorControl_IsClosed(void);
+void MotorControl_SetGains(int32_t Kp, int32_t KiDt);
+void MotorControl_MoveTo(int32_t Target, MotorNotifyFunc_t *OnArrival);
+bool MotorControl_IsMoveDone(void);
+bool MotorControl_SetProfile(int32_t MaxSpeed, int32_t Accel);
+
+#endif /* MotorControl_H */
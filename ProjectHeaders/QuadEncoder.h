@@ -0,0 +1,36 @@
+/****************************************************************************
+ Module
+     QuadEncoder.h
+ Description
+     header file for the interrupt driven quadrature encoder decoder
+ Notes
+     See QuadEncoder.c
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 08:00 mss      the counts per revolution are public, for
+                         MotorControl's position loop
+ 10/17/26 06:00 mss      added the velocity estimate
+ 10/17/26 05:00 mss      started coding
+*****************************************************************************/
+#ifndef QuadEncoder_H
+#define QuadEncoder_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// counts per cycle of the A channel, with every edge of A and B counted
+#define QUAD_ENCODER_COUNTS_PER_CYCLE 4
+// the counts (4x) per revolution of the motor, 360 for the old 2x, and the
+// 1/100 degrees in each one
+#define QUAD_ENCODER_COUNTS_PER_REV 720
+#define QUAD_ENCODER_CENTIDEG_PER_COUNT (36000 / QUAD_ENCODER_COUNTS_PER_REV)
+
+bool QuadEncoder_Init(void);
+int32_t QuadEncoder_GetCount(void);
+void QuadEncoder_SetCount(int32_t NewCount);
+uint32_t QuadEncoder_GetErrorCount(void);
+void QuadEncoder_UpdateVelocity(void);
+int32_t QuadEncoder_GetVelocity(void);
+
+#endif /* QuadEncoder_H */
@@ -8,6 +8,11 @@
  Description
  This is a DC Motor Service set up to work with the Lego NXT gear motor with 
  encoder. The encoder has 360 counts per revolution.
+ The encoder is decoded by QuadEncoder.c in the change notification
+ interrupt, which counts every edge, 720 per revolution.
+ MotorControl.c closes the speed loop for MOTOR_CMD and the position loop
+ for MOTOR_GOTO. The 'l' key sweeps through the 12 LED positions, as a
+ self test of the position control.
 
 ****************************************************************************/
 /*----------------------------- Include Files -----------------------------*/
@@ -29,6 +34,10 @@
 // PWM Lib
 #include "PWM_PIC32.h"
 
+// Encoder
+#include "QuadEncoder.h"
+#include "MotorControl.h"
+
 // This Module
 #include "DCMotorService.h"
 
@@ -55,7 +64,8 @@
 #define H2_PIN _Pin_7
 #define H1 PORTBbits.RB6
 #define H2 PORTBbits.RB7
-#define HOUT PORTBINV
+#define HSET LATBSET
+#define HCLR LATBCLR
 
 // PWM Hardware Constants
 // Enable A
@@ -64,12 +74,12 @@
 #define ENA_TIMER _Timer3_
 #define ENA_FREQ 500 // Hz
 
-// Encoder Ports
-#define ENC_PORT _Port_B
-#define ENCA_PIN _Pin_9
-#define ENCB_PIN _Pin_8
-#define ENCA PORTBbits.RB9
-#define ENCB PORTBbits.RB8
+// QuadEncoder counts per degree, 720 counts per revolution
+#define ENC_COUNTS_PER_DEG 2
+
+// the LED positions, as LEDMissileService has them
+#define NUM_LEDS 12
+#define LED_SPACING_DEG 30
 
 // Motor Limits
 #define LIMIT_COUNT false
@@ -86,8 +96,12 @@
 */
 void SetDir(bool dir);
 void SetSpeed(uint8_t cmd);
-bool DecodeQuadrature(uint8_t CurrentEncAState, uint8_t CurrentEncBState);
 void DecodeMotorKey(char key);
+static void PostEncoderAngle(uint8_t WhichTimer);
+static int32_t GetCountDeg(void);
+static void ApplyDrive(int8_t Duty);
+static void MoveToAngle(uint16_t Angle);
+static void PostMotorArrived(void);
 
 /*---------------------------- Module Variables ---------------------------*/
 static uint8_t MyPriority;
@@ -98,16 +112,13 @@ static bool LastDir = CW;
 // Motor speed: (0-100) percent
 static uint8_t SpeedCmd = 0;
 
-// Motor angular position
-static int32_t Count = 0; // Encoder count starts at the bottom
-
-// encoder states
-static uint8_t LastEncAState;
-static uint8_t LastEncBState;
-
 // bool for initialization
 static bool InitComplete = false;
 
+// the LED sweep, with the LED being moved to
+static bool IsSweeping = false;
+static uint8_t SweepLED;
+
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
@@ -144,19 +155,6 @@ bool InitDCMotorService(uint8_t Priority)
         return false;
     }
 
-    // Configure Motor Encoder pins as digital inputs
-    if (!PortSetup_ConfigureDigitalInputs(ENC_PORT, ENCA_PIN))
-    {
-        return false;
-    }
-    else if (!PortSetup_ConfigureDigitalInputs(ENC_PORT, ENCB_PIN))
-    {
-        return false;
-    }
-
-    // Then initialize Encoder states by reading the encoder pins
-    LastEncAState = ENCA;
-    LastEncBState = ENCB;
 
     /********************************************
    Initialization sequence for timers to do motor drive
@@ -190,6 +188,33 @@ bool InitDCMotorService(uint8_t Priority)
         return false;
     }
 
+    // Start the encoder decoding, the count starts at the bottom. This
+    // comes after the PWM set up since the velocity capture uses Timer3
+    if (!QuadEncoder_Init())
+    {
+        return false;
+    }
+
+    // the speed loop drives the motor through ApplyDrive, from the Timer1
+    // interrupt, once it is given a setpoint
+    if (!MotorControl_Init(ApplyDrive))
+    {
+        return false;
+    }
+
+    // keystrokes are published, so ask for them
+    if (!ES_Subscribe(MyPriority, ES_NEW_KEY))
+    {
+        return false;
+    }
+
+    // the encoder angle is posted straight from the timer tick, without a
+    // trip through our queue
+    if (ES_Timer_SetCallback(ENCODER_TIMER, PostEncoderAngle) != ES_Timer_OK)
+    {
+        return false;
+    }
+
     // post the initial transition event
     ThisEvent.EventType = ES_INIT;
     if (!ES_PostToService(MyPriority, ThisEvent))
@@ -259,10 +284,10 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent)
         else
         {
             H2 = 0;
-            Count = GetAngleDeg();
+            QuadEncoder_SetCount((int32_t)GetAngleDeg() * ENC_COUNTS_PER_DEG);
         }
         //Init Timer to post Angle to LEDMissileService at Fixed Frequency
-        ES_Timer_InitTimer(ENCODER_TIMER, ENCODER_TIME);
+        ES_Timer_InitPeriodic(ENCODER_TIMER, ENCODER_TIME);
     }
     break;
     case (ES_INIT):
@@ -281,21 +306,17 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent)
             InitComplete = false;
         }
         //Init Timer to post Angle to LEDMissileService at Fixed Frequency
-        ES_Timer_InitTimer(ENCODER_TIMER, ENCODER_TIME);
+        ES_Timer_InitPeriodic(ENCODER_TIMER, ENCODER_TIME);
     }
     break;
 
     case ES_TIMEOUT:
     {
         //If ENCODER_TIMER timeout -> post angle to LEDMissileService
+        //(only if the callback was dropped for running too long)
         if (ThisEvent.EventParam == ENCODER_TIMER)
         {
-            ES_Event_t Event2Post;
-            Event2Post.EventType = ENCODER_UPDATE;
-            uint16_t angle = GetAngleDeg();
-            Event2Post.EventParam = angle;
-            PostLEDMissileService(Event2Post);
-            ES_Timer_InitTimer(ENCODER_TIMER, ENCODER_TIME);
+            PostEncoderAngle(ENCODER_TIMER);
         }
 
         //If MOTOR_RESET_TIMER timeout-> post MOTOR_RESET to this service
@@ -309,9 +330,38 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent)
 
     case (MOTOR_CMD):
     {
-        //Set speed of motor as event parameter
-        uint8_t cmd = (uint8_t)ThisEvent.EventParam;
-        SetSpeed(cmd);
+        //Close the speed loop on the event parameter, in deg/S
+        int16_t speed = (int16_t)ThisEvent.EventParam;
+        IsSweeping = false;
+        MotorControl_SetSpeed((int32_t)speed * 100);
+    }
+    break;
+
+    case (MOTOR_GOTO):
+    {
+        //Move to the angle in the event parameter and hold it there
+        IsSweeping = false;
+        MoveToAngle(ThisEvent.EventParam);
+    }
+    break;
+
+    case (MOTOR_ARRIVED):
+    {
+        //Report each LED of a sweep and go on to the next one
+        if (IsSweeping)
+        {
+            DB_printf("\rLED %d: at %d deg\r\n", SweepLED, GetAngleDeg());
+            SweepLED++;
+            if (SweepLED < NUM_LEDS)
+            {
+                MoveToAngle(SweepLED * LED_SPACING_DEG);
+            }
+            else
+            {
+                IsSweeping = false;
+                DB_printf("\rLED sweep done\r\n");
+            }
+        }
     }
     break;
 
@@ -337,6 +387,7 @@ ES_Event_t RunDCMotorService(ES_Event_t ThisEvent)
 uint16_t GetAngleDeg(void)
 {
     uint16_t ang;
+    int32_t Count = GetCountDeg();
     if (Count < 0)
     {
         ang = 360 - ((-Count) % 360);
@@ -350,40 +401,6 @@ uint16_t GetAngleDeg(void)
 
 /*Event Checkers*/
 
-//CheckEncoderEvents is used to get encoder counts
-bool CheckEncoderEvents(void)
-{
-    bool ReturnVal = false;
-    ES_Event_t ThisEvent;
-
-    // Read encoder pins
-    uint8_t CurrentEncAState = ENCA;
-    uint8_t CurrentEncBState = ENCB;
-
-    if (CurrentEncAState != LastEncAState && CurrentEncAState == 0)
-    {
-        // State has changed and CurrentState is low
-
-        //get direction of motor rotation
-        bool dir = DecodeQuadrature(CurrentEncAState, CurrentEncBState);
-        if (dir == CCW)
-        {
-            //if direction is CCW, increment count by 2
-            Count = Count + 2;
-        }
-        else
-        {
-            //if direction is CW, decrement count by 2
-            Count = Count - 2;
-        }
-    }
-    //Update Last Encoder States
-    LastEncAState = CurrentEncAState;
-    LastEncBState = CurrentEncBState;
-
-    return ReturnVal;
-}
-
 //CheckCountLimits function is used to move motor by a fixed angle
 bool CheckCountLimits(void)
 {
@@ -391,6 +408,7 @@ bool CheckCountLimits(void)
     ES_Event_t ThisEvent;
 
 #if (LIMIT_COUNT)
+    int32_t Count = GetCountDeg();
     if (Count >= MAX_COUNT && LastDir == CW)
     {
         DB_printf("\rCount Maxed At: %d\r\n", Count);
@@ -415,13 +433,22 @@ bool CheckCountLimits(void)
  ***************************************************************************/
 
 // SetDir is used to set CW/CCW direction of motor
+// it is called from the speed loop's interrupt as well as from the service,
+// so it writes the H-bridge pins to absolute levels, with single SET/CLR
+// writes, rather than toggling them from where it thinks they are
 void SetDir(bool dir)
 {
-    if (dir != LastDir)
+    if (dir == CW)
+    {
+        HSET = H1_PIN;
+        HCLR = H2_PIN;
+    }
+    else
     {
-        HOUT = (H1_PIN | H2_PIN);
-        LastDir = dir;
+        HCLR = H1_PIN;
+        HSET = H2_PIN;
     }
+    LastDir = dir;
 }
 
 // SetSpeed is used to set the speed of the motor
@@ -433,6 +460,9 @@ cmd>100 and cmd<=201 -> cw direction -> update cmd = cmd - 100 -> set duty = cmd
 */
 void SetSpeed(uint8_t cmd)
 {
+    // driving open loop, so take the motor back from the speed loop
+    MotorControl_Release();
+    IsSweeping = false;
     if (cmd <= 100)
     {
         SetDir(CCW);
@@ -451,43 +481,21 @@ void SetSpeed(uint8_t cmd)
     PWMOperate_SetDutyOnChannel(SpeedCmd, ENA_CHANNEL);
 }
 
-// DecodeQuadrature outputs direction of motor rotation
-bool DecodeQuadrature(uint8_t CurrentEncAState, uint8_t CurrentEncBState)
-{
-    bool dir = LastDir;
-    // Decode quadrature
-    if (CurrentEncAState != LastEncAState)
-    {
-        // A changed
-        if (LastEncAState == 0 && CurrentEncBState > 0)
-        {
-            // Rising edge, B leading A, CCW
-            dir = CCW;
-        }
-        else if (LastEncAState == 0 && CurrentEncBState == 0)
-        {
-            // Rising edge, A leading B, CW
-            dir = CW;
-        }
-        else if (LastEncAState == 1 && CurrentEncBState > 0)
-        {
-            // Falling edge, A leading B, CW
-            dir = CW;
-        }
-        else
-        {
-            // Falling edge, B leading A, CCW
-            dir = CCW;
-        }
-    }
-    return dir;
-}
-
 // DecodeMotorKey is used to control motor direction and speed with keyboard
 void DecodeMotorKey(char key)
 {
-    if (key == 'd')
+    if (key == 'l')
     {
+        //sweep through the LED positions
+        IsSweeping = true;
+        SweepLED = 0;
+        MoveToAngle(0);
+    }
+    else if (key == 'd')
+    {
+        // driving open loop, so take the motor back from the speed loop
+        MotorControl_Release();
+        IsSweeping = false;
         SetDir(!LastDir);
     }
     else if (key == 'w')
@@ -635,3 +643,55 @@ void DecodeMotorKey(char key)
         }
     }
 }
+
+//PostEncoderAngle is the ENCODER_TIMER callback, it posts the angle to
+//LEDMissileService
+static void PostEncoderAngle(uint8_t WhichTimer)
+{
+    ES_Event_t Event2Post;
+    (void)WhichTimer;
+    Event2Post.EventType = ENCODER_UPDATE;
+    Event2Post.EventParam = GetAngleDeg();
+    PostLEDMissileService(Event2Post);
+}
+
+//ApplyDrive is the speed loop's drive function, called from the Timer1
+//interrupt with a duty from -100 (CW) to 100 (CCW)
+static void ApplyDrive(int8_t Duty)
+{
+    if (Duty < 0)
+    {
+        SetDir(CW);
+        SpeedCmd = (uint8_t)(-Duty);
+    }
+    else
+    {
+        SetDir(CCW);
+        SpeedCmd = (uint8_t)Duty;
+    }
+    PWMOperate_SetDutyOnChannel(SpeedCmd, ENA_CHANNEL);
+}
+
+//MoveToAngle has the position loop take the motor to an angle [0,360),
+//the short way round from where it is
+static void MoveToAngle(uint16_t Angle)
+{
+    int32_t Turn = ((int32_t)(Angle % 360) - GetAngleDeg() + 540) % 360 - 180;
+    MotorControl_MoveTo((GetCountDeg() + Turn) * 100, PostMotorArrived);
+}
+
+//PostMotorArrived is called by MotorControl, from its interrupt, when a
+//move is done
+static void PostMotorArrived(void)
+{
+    ES_Event_t Event2Post;
+    Event2Post.EventType = MOTOR_ARRIVED;
+    Event2Post.EventParam = 0;
+    ES_PostToServiceFromISR(MyPriority, Event2Post);
+}
+
+//GetCountDeg is the encoder count in degrees, without wrapping
+static int32_t GetCountDeg(void)
+{
+    return QuadEncoder_GetCount() / ENC_COUNTS_PER_DEG;
+}
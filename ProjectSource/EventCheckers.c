@@ -16,13 +16,18 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 11:10 mss     Check4Keystroke is run when the UART receive
+                        interrupt wakes it rather than being polled
+ 10/17/26 03:00 mss     Check4Keystroke handles the timer statistics keys
+ 10/16/26 18:00 mss     Check4Keystroke publishes ES_NEW_KEY to its subscribers
+ 10/16/26 16:00 mss     Check4Keystroke handles the profiling report keys
  08/06/13 13:36 jec     initial version
 ****************************************************************************/
 
 // this will pull in the symbolic definitions for events, which we will want
 // to post in response to detecting events
 #include "ES_Configure.h"
-// This gets us the prototype for ES_PostAll
+// This gets us the prototype for ES_PostAll & ES_Publish
 #include "ES_Framework.h"
 // this will get us the structure definition for events, which we will need
 // in order to post events in response to detecting events
@@ -36,6 +41,10 @@
 // this test harness for the framework references the serial routines that
 // are defined in ES_Port.c
 #include "ES_Port.h"
+// for the profiling report, when ES_PROFILE is defined
+#include "ES_Profile.h"
+// and for the timer statistics, when ES_TIMER_STATS is defined
+#include "ES_TimerStats.h"
 // include our own prototypes to insure consistency between header &
 // actual functionsdefinition
 #include "EventCheckers.h"
@@ -95,10 +104,18 @@ bool Check4Lock(void)
    bool: true if a new key was detected & posted
  Description
    checks to see if a new key from the keyboard is detected and, if so,
-   retrieves the key and posts an ES_NewKey event to TestHarnessService0
+   retrieves the key and publishes an ES_NEW_KEY event to the services
+   that subscribed to it
  Notes
+   With ES_PROFILE defined, ES_PROFILE_KEY & ES_PROFILE_CLEAR_KEY are taken
+   here to print or clear the service profiles and are not posted.
+   The same goes for ES_TIMER_STATS_KEY & ES_TIMER_STATS_CLEAR_KEY with
+   ES_TIMER_STATS defined, for the timer statistics.
    The functions that actually check the serial hardware for characters
    and retrieve them are assumed to be in ES_Port.c
+   It is ES_TERMINAL_RX_CHECKER, so it is only run after the UART receive
+   interrupt has woken it with ES_CheckerWake. Reading the key re-arms
+   that interrupt.
    Since we always retrieve the keystroke when we detect it, thus clearing the
    hardware flag that indicates that a new key is ready this event checker
    will only generate events on the arrival of new characters, even though we
@@ -113,7 +130,32 @@ bool Check4Keystroke(void)
     ES_Event_t ThisEvent;
     ThisEvent.EventType = ES_NEW_KEY;
     ThisEvent.EventParam = GetNewKey();
-    ES_PostAll(ThisEvent);
+#ifdef ES_PROFILE
+    // the profiling keys are for us, not the services
+    if (ThisEvent.EventParam == ES_PROFILE_KEY)
+    {
+      ES_Profile_Report();
+      return true;
+    }
+    if (ThisEvent.EventParam == ES_PROFILE_CLEAR_KEY)
+    {
+      ES_Profile_Clear();
+      return true;
+    }
+#endif
+#ifdef ES_TIMER_STATS
+    if (ThisEvent.EventParam == ES_TIMER_STATS_KEY)
+    {
+      ES_TimerStats_Report();
+      return true;
+    }
+    if (ThisEvent.EventParam == ES_TIMER_STATS_CLEAR_KEY)
+    {
+      ES_TimerStats_Clear();
+      return true;
+    }
+#endif
+    ES_Publish(ThisEvent);
     return true;
   }
   return false;
@@ -0,0 +1,423 @@
+//#define FIXED_POINT_BENCH
+/****************************************************************************
+ Module
+     FixedPoint.c
+ Description
+     Q15 and Q16.16 fixed point math, with saturating add & multiply, and
+     integer clamping and scaled mapping helpers, so that the services need
+     no float or double math. The PIC32MX has no FPU, every float or double
+     operation is a call into the soft-float library.
+ Notes
+     Saturating: a result that does not fit comes back as the largest or
+     smallest number that does, never wrapped around.
+     Products are formed in 64 bits, which the MIPS mult gives in one
+     instruction, and then shifted back down.
+     Right shifts of negative numbers are arithmetic, as XC32 (gcc) does them.
+     Define FIXED_POINT_BENCH (at the top of this file) to build this file
+     as a benchmark of the service hot paths that were moved onto it, old
+     against new, see the end of the file.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 09:00 mss     started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "FixedPoint.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+
+/*---------------------------- Module Functions ---------------------------*/
+static q16_t Saturate64(int64_t x);
+
+/*---------------------------- Module Variables ---------------------------*/
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   Q15_AddSat
+ Parameters
+   q15_t a, b
+ Returns
+   q15_t, a + b, saturated
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+q15_t Q15_AddSat(q15_t a, q15_t b)
+{
+  return (q15_t)FixedPoint_Clamp((int32_t)a + b, Q15_MIN, Q15_MAX);
+}
+
+/****************************************************************************
+ Function
+   Q15_MulSat
+ Parameters
+   q15_t a, b
+ Returns
+   q15_t, a * b, rounded to the nearest, saturated
+ Notes
+   -1 * -1 is the only product that does not fit
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+q15_t Q15_MulSat(q15_t a, q15_t b)
+{
+  int32_t Product = ((int32_t)a * b + (1 << (Q15_SHIFT - 1))) >> Q15_SHIFT;
+
+  return (q15_t)((Product > Q15_MAX) ? Q15_MAX : Product);
+}
+
+/****************************************************************************
+ Function
+   Q16_AddSat
+ Parameters
+   q16_t a, b
+ Returns
+   q16_t, a + b, saturated
+ Notes
+   The sum has overflowed when it has a different sign from both a and b.
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+q16_t Q16_AddSat(q16_t a, q16_t b)
+{
+  q16_t Sum = (q16_t)((uint32_t)a + (uint32_t)b);
+
+  if (((a ^ Sum) & (b ^ Sum)) < 0)
+  {
+    Sum = (a < 0) ? Q16_MIN : Q16_MAX;
+  }
+  return Sum;
+}
+
+/****************************************************************************
+ Function
+   Q16_SubSat
+ Parameters
+   q16_t a, b
+ Returns
+   q16_t, a - b, saturated
+ Notes
+   The difference has overflowed when a and b have different signs and
+   it has a different sign from a.
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+q16_t Q16_SubSat(q16_t a, q16_t b)
+{
+  q16_t Difference = (q16_t)((uint32_t)a - (uint32_t)b);
+
+  if (((a ^ b) & (a ^ Difference)) < 0)
+  {
+    Difference = (a < 0) ? Q16_MIN : Q16_MAX;
+  }
+  return Difference;
+}
+
+/****************************************************************************
+ Function
+   Q16_MulSat
+ Parameters
+   q16_t a, b
+ Returns
+   q16_t, a * b, rounded to the nearest, saturated
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+q16_t Q16_MulSat(q16_t a, q16_t b)
+{
+  return Saturate64(((int64_t)a * b + (Q16_ONE / 2)) >> Q16_SHIFT);
+}
+
+/****************************************************************************
+ Function
+   Q16_ToInt
+ Parameters
+   q16_t a
+ Returns
+   int32_t, a rounded to the nearest whole number, halves up
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+int32_t Q16_ToInt(q16_t a)
+{
+  return (int32_t)(((int64_t)a + (Q16_ONE / 2)) >> Q16_SHIFT);
+}
+
+/****************************************************************************
+ Function
+   FixedPoint_Clamp
+ Parameters
+   int32_t x, the number to clamp, in any format
+   int32_t Low, High, the limits, in the same format
+ Returns
+   int32_t, x held to Low..High
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+int32_t FixedPoint_Clamp(int32_t x, int32_t Low, int32_t High)
+{
+  if (x < Low)
+  {
+    return Low;
+  }
+  if (x > High)
+  {
+    return High;
+  }
+  return x;
+}
+
+/****************************************************************************
+ Function
+   FixedPoint_Map
+ Parameters
+   int32_t x, the number to map
+   int32_t InLow, InHigh, the input range, InLow < InHigh
+   int32_t OutLow, OutHigh, the output range that it maps onto, either way
+   round
+ Returns
+   int32_t, x mapped linearly from the input range to the output range,
+   rounded toward OutLow
+ Description
+   x is clamped to the input range first, so the result is always in the
+   output range.
+ Notes
+   The product is formed in 64 bits, but when it fits in 32 the divide is
+   done in 32, which is one instruction where the 64 bit one is a library
+   call.
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+int32_t FixedPoint_Map(int32_t x, int32_t InLow, int32_t InHigh,
+    int32_t OutLow, int32_t OutHigh)
+{
+  int64_t Product;
+
+  x = FixedPoint_Clamp(x, InLow, InHigh);
+  Product = (int64_t)(x - InLow) * (OutHigh - OutLow);
+  if ((Product <= INT32_MAX) && (Product >= INT32_MIN))
+  {
+    return OutLow + ((int32_t)Product / (InHigh - InLow));
+  }
+  return OutLow + (int32_t)(Product / (InHigh - InLow));
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   Saturate64
+ Parameters
+   int64_t x
+ Returns
+   q16_t, x held to the 32 bit range
+ Author
+   M. Saboo, 10/17/26, 09:00
+****************************************************************************/
+static q16_t Saturate64(int64_t x)
+{
+  if (x > Q16_MAX)
+  {
+    return Q16_MAX;
+  }
+  if (x < Q16_MIN)
+  {
+    return Q16_MIN;
+  }
+  return (q16_t)x;
+}
+
+/*------------------------------ Test Harness -----------------------------*/
+#ifdef FIXED_POINT_BENCH
+/* Times the math of each service event that was moved off of float and
+   double, as it was and as it is now, with the same inputs. Times are in
+   core timer counts (2 SYSCLKs) per BENCH_EVENTS events. The old code is
+   copied here so that the soft-float library is still linked in to time
+   it. Build with ES_Port.c and terminal.c for the console. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <xc.h>
+#include "ES_Port.h"
+#include "terminal.h"
+
+#define BENCH_EVENTS 1000
+
+// GameService's IR to motor mapping, and its speed range
+#define MAX_READ 1023
+#define MIN_READ 300
+#define MIN_SPEED 130
+#define MAX_SPEED 390
+
+// the inputs, volatile so that the compiler can not fold the math away
+static volatile uint16_t  Reading = 500;
+static volatile uint16_t  Throttle = 900;
+static volatile int       Picks[3] = { 3, 7, 11 };
+static volatile int32_t   Sink;
+
+// GameService SendCmd, as it was
+static uint16_t OldSendCmd(uint16_t val)
+{
+  double cmd;
+  if (val < MIN_READ || val > MAX_READ)
+  {
+    cmd = 0;
+  }
+  else
+  {
+    cmd = 100.00 * (val - MIN_READ) / (MAX_READ - MIN_READ);
+    cmd = cmd * (45.00 - 25.00) / 100.00 + 25.00;
+  }
+  return (uint16_t)cmd;
+}
+
+// GameService SendCmd, now
+static uint16_t NewSendCmd(uint16_t val)
+{
+  if (val < MIN_READ || val > MAX_READ)
+  {
+    return 0;
+  }
+  return (uint16_t)FixedPoint_Map(val, MIN_READ, MAX_READ, MIN_SPEED,
+      MAX_SPEED);
+}
+
+// GameService MISSILE_TIMER, as it was
+static uint16_t OldMissiles(void)
+{
+  uint16_t param = 0;
+  for (int i = 0; i < 3; i++)
+  {
+    param = param + pow(2, Picks[i]);
+  }
+  return param;
+}
+
+// GameService MISSILE_TIMER, now
+static uint16_t NewMissiles(void)
+{
+  uint16_t param = 0;
+  for (int i = 0; i < 3; i++)
+  {
+    param |= (uint16_t)1 << Picks[i];
+  }
+  return param;
+}
+
+// LEDFuelService FUEL_UPDATE, as it was
+static float OldClrLEDs;
+static int OldFuelUpdate(uint16_t throttle)
+{
+  float currClrLEDs = 0.00;
+  if (throttle < 850)
+  {
+    currClrLEDs = 0.35;
+  }
+  else if (throttle < 925)
+  {
+    currClrLEDs = 0.53;
+  }
+  else if (throttle < 1024)
+  {
+    currClrLEDs = 1.06;
+  }
+  OldClrLEDs = OldClrLEDs + currClrLEDs;
+  if (OldClrLEDs >= 255)
+  {
+    OldClrLEDs = 0;
+  }
+  return OldClrLEDs / 85;
+}
+
+// LEDFuelService FUEL_UPDATE, now
+static q16_t NewClrLEDs;
+static int NewFuelUpdate(uint16_t throttle)
+{
+  q16_t currClrLEDs = 0;
+  if (throttle < 850)
+  {
+    currClrLEDs = Q16(0.35);
+  }
+  else if (throttle < 925)
+  {
+    currClrLEDs = Q16(0.53);
+  }
+  else if (throttle < 1024)
+  {
+    currClrLEDs = Q16(1.06);
+  }
+  NewClrLEDs = Q16_AddSat(NewClrLEDs, currClrLEDs);
+  if (NewClrLEDs >= Q16_FROM_INT(255))
+  {
+    NewClrLEDs = 0;
+  }
+  return NewClrLEDs / Q16_FROM_INT(85);
+}
+
+void main(void)
+{
+  uint16_t  Event;
+  uint32_t  StartTime;
+  uint32_t  OldTime;
+  uint32_t  NewTime;
+
+  _HW_PIC32Init();
+  puts("\rFixed point benchmark, counts per event\r");
+
+  StartTime = _CP0_GET_COUNT();
+  for (Event = 0; Event < BENCH_EVENTS; Event++)
+  {
+    Sink = OldSendCmd(Reading);
+  }
+  OldTime = _CP0_GET_COUNT() - StartTime;
+  StartTime = _CP0_GET_COUNT();
+  for (Event = 0; Event < BENCH_EVENTS; Event++)
+  {
+    Sink = NewSendCmd(Reading);
+  }
+  NewTime = _CP0_GET_COUNT() - StartTime;
+  printf("SendCmd        old %5lu  new %5lu\r\n",
+      (unsigned long)(OldTime / BENCH_EVENTS),
+      (unsigned long)(NewTime / BENCH_EVENTS));
+
+  StartTime = _CP0_GET_COUNT();
+  for (Event = 0; Event < BENCH_EVENTS; Event++)
+  {
+    Sink = OldMissiles();
+  }
+  OldTime = _CP0_GET_COUNT() - StartTime;
+  StartTime = _CP0_GET_COUNT();
+  for (Event = 0; Event < BENCH_EVENTS; Event++)
+  {
+    Sink = NewMissiles();
+  }
+  NewTime = _CP0_GET_COUNT() - StartTime;
+  printf("MISSILE_TIMER  old %5lu  new %5lu\r\n",
+      (unsigned long)(OldTime / BENCH_EVENTS),
+      (unsigned long)(NewTime / BENCH_EVENTS));
+
+  StartTime = _CP0_GET_COUNT();
+  for (Event = 0; Event < BENCH_EVENTS; Event++)
+  {
+    Sink = OldFuelUpdate(Throttle);
+  }
+  OldTime = _CP0_GET_COUNT() - StartTime;
+  StartTime = _CP0_GET_COUNT();
+  for (Event = 0; Event < BENCH_EVENTS; Event++)
+  {
+    Sink = NewFuelUpdate(Throttle);
+  }
+  NewTime = _CP0_GET_COUNT() - StartTime;
+  printf("FUEL_UPDATE    old %5lu  new %5lu\r\n",
+      (unsigned long)(OldTime / BENCH_EVENTS),
+      (unsigned long)(NewTime / BENCH_EVENTS));
+
+  while (1)
+  {
+    Terminal_MoveBuffer2UART(); // printf only fills the transmit buffer
+  }
+}
+#endif
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
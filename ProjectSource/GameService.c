@@ -21,7 +21,6 @@
 //Standard c libraries
 #include <stdbool.h>
 #include <stdlib.h>
-#include <math.h>
 
 //Services Headers
 #include "GameService.h"
@@ -34,6 +33,9 @@
 #include "OptoSensorService.h"
 #include "IRService.h"
 
+// Fixed point math
+#include "FixedPoint.h"
+
 // PWM Lib
 #include "PWM_PIC32.h"
 
@@ -64,6 +66,10 @@
 #define CCWTHRESH MID - THRESH
 #define CWRANGE MAX_READ - MID - THRESH
 #define CCWRANGE MID - THRESH - MIN_READ
+// the speed setpoints that the IR range maps to, in degrees per second,
+// about what the 25% to 45% duty that it used to map to gave
+#define MIN_SPEED 130
+#define MAX_SPEED 390
 
 //delta used to determine if throttle values changed
 #define deltaThrottle 10
@@ -297,11 +303,11 @@ ES_Event_t RunGameService(ES_Event_t ThisEvent)
                 Event2Post.EventType = FIRE_MISSILE;
                 int randNumMissiles = numMissiles; //1,2,3
                 uint16_t param = 0;
-                //use binary to int conversion to send missile numbers to LEDMissileService
+                //set one bit per missile to send missile numbers to LEDMissileService
                 for (int i = 0; i < randNumMissiles; i++)
                 {
                     int r = rand() % 12;
-                    param = param + pow(2, r);
+                    param |= (uint16_t)1 << r;
                 }
                 Event2Post.EventParam = param;
                 //post to LEDMissileService
@@ -458,23 +464,23 @@ ES_Event_t RunGameService(ES_Event_t ThisEvent)
 //function used to map and send speed to dc motor
 void SendCmd(uint16_t val)
 {
-    // Determine cmd
-    double cmd;
+    // Determine the speed setpoint in degrees per second
+    int16_t speed;
     if (val < MIN_READ || val > MAX_READ)
     {
         //if values are out of bound - stop motor
-        cmd = 0;
+        speed = 0;
     }
     else
     {
         //map ir values to dc motor speed
-        cmd = 100.00 * (val - MIN_READ) / (MAX_READ - MIN_READ);
-        cmd = cmd * (45.00 - 25.00) / 100.00 + 25.00;
+        speed = (int16_t)FixedPoint_Map(val, MIN_READ, MAX_READ, MIN_SPEED,
+                MAX_SPEED);
     }
 
     //post speed to dc motor service
     ES_Event_t Event2Post;
     Event2Post.EventType = MOTOR_CMD;
-    Event2Post.EventParam = (uint16_t)cmd;
+    Event2Post.EventParam = (uint16_t)speed;
     PostDCMotorService(Event2Post);
 }
@@ -140,8 +140,8 @@ ES_Event_t RunIRService(ES_Event_t ThisEvent)
   {
     //Read Value to LastPostedValue
     ADC_MultiRead(LastPostedValue);
-    //Start Timer
-    ES_Timer_InitTimer(IR_TIMER, WAIT);
+    //Start Timer, it re-arms itself every WAIT
+    ES_Timer_InitPeriodic(IR_TIMER, WAIT);
   }
   break;
 
@@ -171,8 +171,6 @@ ES_Event_t RunIRService(ES_Event_t ThisEvent)
     }
     //set lastPostValue to currentValue
     LastPostedValue[2] = currentVal[2];
-    //Re-Init Timer
-    ES_Timer_InitTimer(IR_TIMER, WAIT);
   }
   default:
   {
@@ -35,6 +35,9 @@ Service for calculating fuel value and indicating using 3 LEDs
 #include "DM_Display.h"
 #include "FontStuff.h"
 
+// Fixed point math
+#include "FixedPoint.h"
+
 /*----------------------------- Module Defines ----------------------------*/
 
 #define LED1_PIN _Pin_1
@@ -50,8 +53,8 @@ Service for calculating fuel value and indicating using 3 LEDs
 /*----------------------------- Module Variables ----------------------------*/
 static uint8_t MyPriority;
 
-//variable that stores total LEDs cleared till now (max is 255)
-float clrLEDs;
+//variable that stores total LEDs cleared till now (max is 255), in Q16.16
+q16_t clrLEDs;
 //initial or max fuel value is pow(2,32)
 uint32_t fuel = 0b11111111111111111111111111111111;
 //variable that stores LEDs to be cleared in current update step
@@ -64,7 +67,7 @@ int prev_rows;
 /*----------------------------- Private Functions ----------------------------*/
 
 //this function decides fuel burn rate depending on the throttle value
-float throttleToLED(uint16_t throttle);
+q16_t throttleToLED(uint16_t throttle);
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -186,12 +189,12 @@ ES_Event_t RunLEDFuelService(ES_Event_t ThisEvent)
     //Read Throttle Value
     uint16_t throttle = ThisEvent.EventParam;
     //Decide Fuel Drop Rate
-    float currClrLEDs = throttleToLED(throttle);
+    q16_t currClrLEDs = throttleToLED(throttle);
     //Total Number of LEDs to be Cleared (255 mapped to 3)
-    clrLEDs = clrLEDs + currClrLEDs;
+    clrLEDs = Q16_AddSat(clrLEDs, currClrLEDs);
 
     //if out of fuel, post fuel_done to game
-    if (clrLEDs >= 255)
+    if (clrLEDs >= Q16_FROM_INT(255))
     {
       ES_Event_t Event2Post;
       Event2Post.EventType = FUEL_DONE;
@@ -202,7 +205,7 @@ ES_Event_t RunLEDFuelService(ES_Event_t ThisEvent)
     }
 
     //interpolate 255 leds to 3 leds and turn of LEDs depending on values
-    new_rows = clrLEDs / 85;
+    new_rows = clrLEDs / Q16_FROM_INT(85);
     if (new_rows != prev_rows)
     {
 
@@ -232,21 +235,22 @@ ES_Event_t RunLEDFuelService(ES_Event_t ThisEvent)
 
 //private functions
 
-//this function decides fuel burn rate depending on the throttle value
-float throttleToLED(uint16_t throttle)
+//this function decides fuel burn rate depending on the throttle value,
+//in Q16.16 LEDs per update
+q16_t throttleToLED(uint16_t throttle)
 {
-  float returnVal = 0.00;
+  q16_t returnVal = 0;
   if (throttle < 850)
   {
-    returnVal = 0.35;
+    returnVal = Q16(0.35);
   }
   else if (throttle < 925)
   {
-    returnVal = 0.53;
+    returnVal = Q16(0.53);
   }
   else if (throttle < 1024)
   {
-    returnVal = 1.06;
+    returnVal = Q16(1.06);
   }
   return returnVal;
 }
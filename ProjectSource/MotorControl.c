@@ -0,0 +1,947 @@
+//#define MOTOR_CONTROL_SIM
+/****************************************************************************
+ Module
+     MotorControl.c
+ Description
+     Closed loop speed and position control of the DC motor. A PI loop run
+     by the Timer1 interrupt at MOTOR_CONTROL_HZ drives the motor so that the
+     encoder velocity follows the speed set with MotorControl_SetSpeed, or
+     the speed that the position loop asks for after MotorControl_MoveTo.
+ Notes
+     The loop's math is all Q16.16 fixed point: the error is taken to
+     degrees per second in Q16.16, the gains are Q16.16 and the integral and
+     the output are percent duty in Q16.16, with the saturating math of
+     FixedPoint.c. The output is saturated at
+     +/-100% and then rounded to the whole percent that the PWM library
+     takes.
+     Anti-windup is by clamping: while the output is saturated the integral
+     is not moved any further in the direction of the saturation, and it is
+     never allowed past +/-100% on its own.
+     Each interrupt first has QuadEncoder make its velocity estimate, so the
+     loop rate is also the encoder's velocity window.
+     Position: MotorControl_MoveTo plans a trapezoidal profile to the target,
+     a step at a time in the interrupt, accelerating at the profile's
+     acceleration up to its top speed and braking on the curve v^2 = 2ad
+     so that it stops on the target. Planning it a step at a time lets a
+     new target be given in the middle of a move. The position loop is
+     cascaded over the speed loop: the profile's speed is fed forward and a
+     P term on the error from the profile's position is added to it, to
+     give the speed loop its setpoint. The profile's speed and acceleration
+     are also fed forward to the duty, through a model of the motor, so
+     that the loops only have to make up for where the model is off.
+     A move is done when the profile is
+     at the target and the motor is within ARRIVED_ERROR of it, nearly
+     stopped. The loop then goes on holding the target.
+     The motor is driven through the function given to MotorControl_Init,
+     from the interrupt. MotorControl_Release stops the loop driving it, so
+     that the caller can drive it open loop again.
+     Define MOTOR_CONTROL_SIM (at the top of this file, or with -D) to build
+     this file on its own on a PC, as a test of the loop against a model of
+     the motor, see the module test harness at the end:
+       gcc -DMOTOR_CONTROL_SIM -IProjectHeaders ProjectSource/MotorControl.c
+           ProjectSource/FixedPoint.c -lm
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 10:40 mss     the Q16.16 math is FixedPoint.c's, the products round
+                        and the sums saturate
+ 10/17/26 10:30 mss     the profile's position is 64 bits, it overflowed 32
+                        after about 600 turns of the encoder count
+ 10/17/26 08:00 mss     added position control with a trapezoidal profile
+ 10/17/26 07:00 mss     started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#ifndef MOTOR_CONTROL_SIM
+#include <xc.h>
+#include <sys/attribs.h>
+#endif
+#include <stdlib.h>
+#include "QuadEncoder.h"
+#include "FixedPoint.h"
+#include "MotorControl.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// the limits of the output, and of the integral
+#define OUT_MAX (100 * Q16_ONE)
+
+// 1/100 in Q0.32, so that one multiply and a shift of 16 takes 1/100
+// degree per second to degrees per second in Q16.16
+#define CENTI_Q32 42949673LL
+
+// The gains for the Lego NXT motor turning the helicopter, modeled as a
+// first order lag of about 150mS with 13 degrees per second per percent
+// duty, after 15% to get it moving. Kp puts the crossover at about 10
+// rad/S and Ki puts the PI zero on the motor's pole. On this model the
+// test harness has the loop still stable at 32x these gains, but the
+// overshoot passes 10% at about 2.5x.
+#define DEFAULT_KP Q16(0.115)                       // % per degree/S
+#define DEFAULT_KI_DT Q16(0.77 / MOTOR_CONTROL_HZ)  // % per degree/S per loop
+
+// The default move profile. 360 degrees per second is about what 45% duty
+// gives, and at 500 degrees per second^2 a move to the next LED, 30
+// degrees away, takes half a second
+#define DEFAULT_MAX_SPEED 36000   // 1/100 degree per second
+#define DEFAULT_ACCEL 50000       // 1/100 degree per second^2
+// a position in 1/100 degree on the profile's scale, see ProfilePos
+#define ToProfilePos(x) ((int64_t)(x) * MOTOR_CONTROL_HZ)
+// the farthest that the profile plans its braking over, on its scale. About
+// 300 turns, far more than it takes to stop from any top speed
+#define MAX_REACH ((uint64_t)1 << 30)
+// the position loop gain, per second. It can be this close to the speed
+// loop's 10 rad/S since the feedforward leaves it little to do
+#define DEFAULT_KPOS Q16(8.0)
+// the model of the motor above, to feed the profile forward to the duty
+#define FF_PER_SPEED Q16(1.0 / 13.0)  // % per degree/S
+#define FF_FRICTION Q16(15.0)         // %
+#define FF_LAG_LOOPS 15               // the motor's lag, 150mS, in loops
+// a move is done with the motor this close to the target and this slow,
+// well inside the 10 degrees that LEDMissileService counts as a hit
+#define ARRIVED_ERROR 200         // 1/100 degree
+#define ARRIVED_SPEED 1000        // 1/100 degree per second
+// a position error of up to a count is left alone, so that holding a
+// target does not dither between two counts
+#define HOLD_BAND QUAD_ENCODER_CENTIDEG_PER_COUNT
+
+// Timer1 counts PBCLK (20MHz) / 8
+#define T1_PRESCALE_8 0b01
+#define T1_COUNTS_PER_SEC 2500000
+// interrupt priority, must match the IPL in the __ISR() below. Under the
+// encoder (5), whose counts the loop reads, over the tick (3)
+#define CONTROL_PRIORITY 4
+
+#ifndef MOTOR_CONTROL_SIM
+// hold the loop off while its state is changed from a service
+#define HoldLoop() (IEC0CLR = _IEC0_T1IE_MASK)
+#define ResumeLoop() (IEC0SET = _IEC0_T1IE_MASK)
+// the encoder, in 1/100 degree and 1/100 degree per second
+#define ReadPosition() \
+  (QuadEncoder_GetCount() * QUAD_ENCODER_CENTIDEG_PER_COUNT)
+#define ReadVelocity() QuadEncoder_GetVelocity()
+#else
+#define HoldLoop()
+#define ResumeLoop()
+// the test harness's model of the encoder
+#define ReadPosition() SimPosition
+#define ReadVelocity() SimVelocity
+#endif
+
+/*------------------------------ Module Types -----------------------------*/
+typedef enum
+{
+  LoopOpen,
+  LoopSpeed,
+  LoopPosition
+}LoopMode_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void StepLoop(void);
+static int32_t StepPosition(int32_t Position, int32_t Velocity);
+static void StepProfile(void);
+static uint32_t ISqrt(uint64_t x);
+static int32_t FeedForward(void);
+static int8_t StepPI(int32_t Target, int32_t Velocity, int32_t Bias);
+
+/*---------------------------- Module Variables ---------------------------*/
+static MotorDriveFunc_t     *pDrive;
+static volatile LoopMode_t  Mode;
+static volatile int32_t     Setpoint;       // 1/100 degree per second
+static q16_t                Integral;       // percent duty
+static q16_t                Kp    = DEFAULT_KP;
+static q16_t                KiDt  = DEFAULT_KI_DT;
+
+// The move. The profile's position is in 1/100 degree * MOTOR_CONTROL_HZ,
+// so that adding its speed each loop integrates it exactly. That is 64 bits,
+// in 32 it would overflow after about 600 turns
+static int32_t              Target;         // 1/100 degree
+static int64_t              ProfilePos;
+static int32_t              ProfileSpeed;   // 1/100 degree per second
+static int32_t              LastProfileSpeed;
+static int32_t              MaxSpeed  = DEFAULT_MAX_SPEED;
+static int32_t              Accel     = DEFAULT_ACCEL;
+static int32_t              SpeedStep = DEFAULT_ACCEL / MOTOR_CONTROL_HZ;
+static q16_t                KPos      = DEFAULT_KPOS;
+static volatile bool        IsMoveDone;
+static MotorNotifyFunc_t    *pOnArrival;
+
+#ifdef MOTOR_CONTROL_SIM
+static int32_t              SimPosition;
+static int32_t              SimVelocity;
+#endif
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   MotorControl_Init
+ Parameters
+   MotorDriveFunc_t * : DriveFunc, the function that drives the motor
+ Returns
+   bool, false if there is no drive function
+ Description
+   starts Timer1 interrupting at MOTOR_CONTROL_HZ, with the loop open. The
+   interrupt updates the encoder velocity even while the loop is open.
+ Notes
+   call after QuadEncoder_Init
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+bool MotorControl_Init(MotorDriveFunc_t *DriveFunc)
+{
+  if (DriveFunc == (MotorDriveFunc_t *)0)
+  {
+    return false;
+  }
+  pDrive      = DriveFunc;
+  Mode        = LoopOpen;
+  Integral    = 0;
+  IsMoveDone  = false;
+#ifndef MOTOR_CONTROL_SIM
+  T1CON           = 0;                // off, PBCLK
+  T1CONbits.TCKPS = T1_PRESCALE_8;
+  TMR1            = 0;
+  PR1             = (T1_COUNTS_PER_SEC / MOTOR_CONTROL_HZ) - 1;
+  IFS0CLR         = _IFS0_T1IF_MASK;
+  IPC1bits.T1IP   = CONTROL_PRIORITY;
+  IEC0SET         = _IEC0_T1IE_MASK;
+  T1CONbits.ON    = 1;
+#endif
+  return true;
+}
+
+/****************************************************************************
+ Function
+   MotorControl_SetSpeed
+ Parameters
+   int32_t Setpoint, the speed to hold in 1/100 degree per second,
+   positive for CCW
+ Returns
+   nothing
+ Description
+   sets the speed that the loop holds, and closes the loop if it was open
+ Notes
+   Closing the loop starts the integral over from 0. Changing the speed of
+   a closed loop leaves it alone, so the change is smooth. Ends any move.
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+void MotorControl_SetSpeed(int32_t NewSetpoint)
+{
+  HoldLoop();
+  if (Mode == LoopOpen)
+  {
+    Integral = 0;
+  }
+  Mode        = LoopSpeed;
+  Setpoint    = NewSetpoint;
+  IsMoveDone  = false;
+  ResumeLoop();
+}
+
+/****************************************************************************
+ Function
+   MotorControl_MoveTo
+ Parameters
+   int32_t NewTarget, the encoder position to go to, in 1/100 degree
+   MotorNotifyFunc_t * : OnArrival, called when the move is done, or 0
+ Returns
+   nothing
+ Description
+   moves the motor to the target on the move profile and then holds it
+   there, closing the loop if it was open
+ Notes
+   The target is on the encoder's own scale, with no wrap at 360 degrees,
+   so the caller picks which way round to go. If a move is already under
+   way the profile goes on from where it is, at the speed it has, toward
+   the new target. Otherwise it starts from where the motor is, at the
+   speed it is turning.
+   OnArrival is called once, from the loop's interrupt.
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+void MotorControl_MoveTo(int32_t NewTarget, MotorNotifyFunc_t *OnArrival)
+{
+  HoldLoop();
+  if ((Mode != LoopPosition) || IsMoveDone)
+  {
+    // the feedforward takes over from whatever the integral had built up
+    // to hold a speed, or to hold the last target against friction
+    Integral = 0;
+  }
+  if (Mode != LoopPosition)
+  {
+    ProfilePos    = ToProfilePos(ReadPosition());
+    ProfileSpeed  = ReadVelocity();
+    LastProfileSpeed = ProfileSpeed;
+    if (ProfileSpeed > MaxSpeed)
+    {
+      ProfileSpeed = MaxSpeed;
+    }
+    else if (ProfileSpeed < -MaxSpeed)
+    {
+      ProfileSpeed = -MaxSpeed;
+    }
+    Mode = LoopPosition;
+  }
+  Target      = NewTarget;
+  pOnArrival  = OnArrival;
+  IsMoveDone  = false;
+  ResumeLoop();
+}
+
+/****************************************************************************
+ Function
+   MotorControl_IsMoveDone
+ Parameters
+   None
+ Returns
+   bool, true if the last move has arrived and the loop is holding it
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+bool MotorControl_IsMoveDone(void)
+{
+  return IsMoveDone;
+}
+
+/****************************************************************************
+ Function
+   MotorControl_SetProfile
+ Parameters
+   int32_t NewMaxSpeed, the top speed of a move, 1/100 degree per second
+   int32_t NewAccel, its acceleration, 1/100 degree per second^2
+ Returns
+   bool, false if either is not positive
+ Description
+   replaces the move profile, it applies to a move under way from the
+   next loop on
+ Notes
+   NewAccel is used to the nearest MOTOR_CONTROL_HZ below it, and at least
+   that
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+bool MotorControl_SetProfile(int32_t NewMaxSpeed, int32_t NewAccel)
+{
+  if ((NewMaxSpeed <= 0) || (NewAccel <= 0))
+  {
+    return false;
+  }
+  HoldLoop();
+  MaxSpeed  = NewMaxSpeed;
+  SpeedStep = NewAccel / MOTOR_CONTROL_HZ;
+  if (SpeedStep == 0)
+  {
+    SpeedStep = 1;
+  }
+  Accel     = SpeedStep * MOTOR_CONTROL_HZ;
+  ResumeLoop();
+  return true;
+}
+
+/****************************************************************************
+ Function
+   MotorControl_Release
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   opens the loop. The motor is left as the loop last drove it, for the
+   caller to drive from then on. Ends any move.
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+void MotorControl_Release(void)
+{
+  HoldLoop();
+  Mode        = LoopOpen;
+  IsMoveDone  = false;
+  ResumeLoop();
+}
+
+/****************************************************************************
+ Function
+   MotorControl_IsClosed
+ Parameters
+   None
+ Returns
+   bool, true if the loop is driving the motor
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+bool MotorControl_IsClosed(void)
+{
+  return Mode != LoopOpen;
+}
+
+/****************************************************************************
+ Function
+   MotorControl_SetGains
+ Parameters
+   int32_t Kp, percent duty per degree per second, Q16.16
+   int32_t KiDt, percent duty per degree per second per loop, Q16.16 (the
+   integral gain divided by MOTOR_CONTROL_HZ)
+ Returns
+   nothing
+ Description
+   replaces the gains, for tuning
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+void MotorControl_SetGains(int32_t NewKp, int32_t NewKiDt)
+{
+  HoldLoop();
+  Kp    = NewKp;
+  KiDt  = NewKiDt;
+  ResumeLoop();
+}
+
+#ifndef MOTOR_CONTROL_SIM
+/****************************************************************************
+ Function
+   MotorControlISR
+ Description
+   the Timer1 interrupt response, updates the encoder velocity and runs
+   the loop
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+void __ISR(_TIMER_1_VECTOR, IPL4AUTO) MotorControlISR(void)
+{
+  IFS0CLR = _IFS0_T1IF_MASK;
+  QuadEncoder_UpdateVelocity();
+  StepLoop();
+}
+#endif
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   StepLoop
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   one pass of the loop, in the mode it is in, driving the motor unless
+   it is open
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+static void StepLoop(void)
+{
+  int32_t Velocity = ReadVelocity();
+  int32_t Command;
+
+  switch (Mode)
+  {
+    case LoopSpeed:
+    {
+      pDrive(StepPI(Setpoint, Velocity, 0));
+    }
+    break;
+
+    case LoopPosition:
+    {
+      Command = StepPosition(ReadPosition(), Velocity);
+      pDrive(StepPI(Command, Velocity, FeedForward()));
+    }
+    break;
+
+    default:
+    {}
+    break;
+  }
+}
+
+/****************************************************************************
+ Function
+   StepPosition
+ Parameters
+   int32_t Position, the measured position in 1/100 degree
+   int32_t Velocity, the measured velocity in 1/100 degree per second
+ Returns
+   int32_t, the speed setpoint for the speed loop, 1/100 degree per second
+ Description
+   moves the profile on a step and closes the position loop on it, and
+   reports the arrival at the target
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+static int32_t StepPosition(int32_t Position, int32_t Velocity)
+{
+  int32_t Error;
+
+  StepProfile();
+  Error = (int32_t)(ProfilePos / MOTOR_CONTROL_HZ) - Position;
+
+  if (!IsMoveDone && (ProfileSpeed == 0) &&
+      (ProfilePos == ToProfilePos(Target)) &&
+      (abs(Target - Position) <= ARRIVED_ERROR) &&
+      (abs(Velocity) <= ARRIVED_SPEED))
+  {
+    IsMoveDone = true;
+    if (pOnArrival != (MotorNotifyFunc_t *)0)
+    {
+      pOnArrival();
+    }
+  }
+
+  if (abs(Error) <= HOLD_BAND)
+  {
+    Error = 0;
+  }
+  return ProfileSpeed + Q16_MulSat(KPos, Error);
+}
+
+/****************************************************************************
+ Function
+   StepProfile
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   moves the profile's speed and position on by one loop toward the target
+ Notes
+   The speed is taken toward the fastest that can still stop in the
+   distance left (v^2 = 2ad) or the top speed, whichever is lower, by no
+   more than a loop's acceleration. Once it is on the braking curve it
+   follows it down. The step that would reach or pass the target lands
+   on it and stops.
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+static void StepProfile(void)
+{
+  int64_t   Distance = ToProfilePos(Target) - ProfilePos;
+  uint64_t  Reach = (uint64_t)llabs(Distance);
+  uint32_t  Root;
+  int32_t   Wanted;
+
+  LastProfileSpeed = ProfileSpeed;
+  if ((Distance == 0) && (ProfileSpeed == 0))
+  {
+    return;
+  }
+
+  // v (v + SpeedStep) = 2ad, stepping down by SpeedStep each loop. Past
+  // MAX_REACH the top speed is wanted whatever the distance, which keeps
+  // the products in 64 bits
+  if (Reach > MAX_REACH)
+  {
+    Reach = MAX_REACH;
+  }
+  Root = ISqrt((uint64_t)SpeedStep * SpeedStep +
+      ((uint64_t)8 * (uint32_t)Accel * Reach) / MOTOR_CONTROL_HZ);
+  Wanted = (int32_t)((Root - (uint32_t)SpeedStep) / 2);
+  if (Wanted > MaxSpeed)
+  {
+    Wanted = MaxSpeed;
+  }
+  if (Distance < 0)
+  {
+    Wanted = -Wanted;
+  }
+
+  if ((abs(Wanted) < abs(ProfileSpeed)) && ((Wanted ^ ProfileSpeed) >= 0))
+  {
+    ProfileSpeed = Wanted;              // braking
+  }
+  else if (Wanted > ProfileSpeed + SpeedStep)
+  {
+    ProfileSpeed += SpeedStep;
+  }
+  else if (Wanted < ProfileSpeed - SpeedStep)
+  {
+    ProfileSpeed -= SpeedStep;
+  }
+  else
+  {
+    ProfileSpeed = Wanted;
+  }
+
+  // the speed is 1/100 degree * MOTOR_CONTROL_HZ per loop
+  if (((Distance ^ ProfileSpeed) >= 0) && (Reach <= abs(ProfileSpeed)))
+  {
+    ProfilePos    = ToProfilePos(Target);
+    ProfileSpeed  = 0;
+  }
+  else
+  {
+    ProfilePos += ProfileSpeed;
+  }
+}
+
+/****************************************************************************
+ Function
+   ISqrt
+ Parameters
+   uint64_t x
+ Returns
+   uint32_t, the square root of x, rounded down
+ Notes
+   bit by bit, two bits of x for each bit of the root
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+static uint32_t ISqrt(uint64_t x)
+{
+  uint64_t  Bit = (uint64_t)1 << 62;
+  uint64_t  Root = 0;
+
+  while (Bit > x)
+  {
+    Bit >>= 2;
+  }
+  while (Bit != 0)
+  {
+    if (x >= Root + Bit)
+    {
+      x    -= Root + Bit;
+      Root  = (Root >> 1) + Bit;
+    }
+    else
+    {
+      Root >>= 1;
+    }
+    Bit >>= 2;
+  }
+  return (uint32_t)Root;
+}
+
+/****************************************************************************
+ Function
+   FeedForward
+ Parameters
+   None
+ Returns
+   int32_t, the duty that the model of the motor says the profile's speed
+   and acceleration take, percent in Q16.16
+ Description
+   The speed is led by the motor's lag times the acceleration, and the
+   friction is added in the direction of travel. This way the PI only has
+   to make up for where the model is off, and the position error stays
+   small enough that the P term does not have to drive the move.
+ Notes
+   There is no lead on the step where the profile lands on the target and
+   stops, that step is not an acceleration the motor should follow.
+ Author
+   M. Saboo, 10/17/26, 08:00
+****************************************************************************/
+static int32_t FeedForward(void)
+{
+  int32_t Speed;
+
+  if (ProfileSpeed == 0)
+  {
+    return 0;
+  }
+  Speed = ProfileSpeed + (ProfileSpeed - LastProfileSpeed) * FF_LAG_LOOPS;
+  // to degrees per second, Q16.16
+  Speed = (int32_t)(((int64_t)Speed * CENTI_Q32) >> Q16_SHIFT);
+  return Q16_AddSat(Q16_MulSat(FF_PER_SPEED, Speed),
+      (Speed >= 0) ? FF_FRICTION : -FF_FRICTION);
+}
+
+/****************************************************************************
+ Function
+   StepPI
+ Parameters
+   int32_t Target, the setpoint in 1/100 degree per second
+   int32_t Velocity, the measured velocity in 1/100 degree per second
+   int32_t Bias, a feedforward duty to add, percent in Q16.16
+ Returns
+   int8_t, the duty to drive the motor with, -100 to 100 percent
+ Description
+   one step of the PI, with the integral clamped against windup
+ Author
+   M. Saboo, 10/17/26, 07:00
+****************************************************************************/
+static int8_t StepPI(int32_t Target, int32_t Velocity, int32_t Bias)
+{
+  int32_t Error;
+  int32_t NewIntegral;
+  int32_t Output;
+
+  // degrees per second, Q16.16
+  Error = (int32_t)(((int64_t)(Target - Velocity) * CENTI_Q32) >> Q16_SHIFT);
+
+  NewIntegral = Q16_AddSat(Integral, Q16_MulSat(KiDt, Error));
+  if (NewIntegral > OUT_MAX)
+  {
+    NewIntegral = OUT_MAX;
+  }
+  else if (NewIntegral < -OUT_MAX)
+  {
+    NewIntegral = -OUT_MAX;
+  }
+
+  Output = Q16_AddSat(Q16_AddSat(Q16_MulSat(Kp, Error), NewIntegral), Bias);
+  if (Output > OUT_MAX)
+  {
+    Output = OUT_MAX;
+    if (Error > 0)
+    {
+      NewIntegral = Integral;   // don't wind further into the saturation
+    }
+  }
+  else if (Output < -OUT_MAX)
+  {
+    Output = -OUT_MAX;
+    if (Error < 0)
+    {
+      NewIntegral = Integral;
+    }
+  }
+  Integral = NewIntegral;
+
+  // round to the nearest percent
+  return (int8_t)Q16_ToInt(Output);
+}
+
+/*------------------------------ Test Harness -----------------------------*/
+#ifdef MOTOR_CONTROL_SIM
+#include <stdio.h>
+#include <math.h>
+
+// the motor: Tau dW/dt = K (Duty - Friction) - W - Load, W in degrees/S,
+// Duty in percent, Friction the duty it takes to get going
+typedef struct
+{
+  const char  *Name;
+  double      K;          // degrees/S per percent
+  double      Tau;        // S
+  double      Friction;   // percent
+  double      Load;       // degrees/S lost to the load
+}Plant_t;
+
+typedef struct
+{
+  double Overshoot;   // percent of the step
+  double SettleTime;  // S, to stay within 5% of the setpoint
+  double MeanError;   // degrees/S over the last second
+  double Ripple;      // degrees/S peak to peak over the last second
+}Response_t;
+
+typedef struct
+{
+  double ArriveTime;  // S, to the arrival callback, or -1 if it never came
+  double Overshoot;   // degrees past the target
+  double MaxLag;      // degrees, the worst error from the profile
+  double FinalError;  // degrees, at the end
+}Move_t;
+
+#define SIM_STEPS_PER_LOOP 10
+#define SIM_SECONDS 4.0
+
+static double Speed;      // the plant's true speed, degrees/S
+static double Angle;      // and its true angle, degrees
+static double Filtered;   // the velocity estimate, as QuadEncoder filters it
+static int8_t LastDuty;   // what the loop last drove the motor with
+static bool   Arrived;
+
+static void SimDrive(int8_t SignedDuty)
+{
+  LastDuty = SignedDuty;
+}
+
+static void SimArrived(void)
+{
+  Arrived = true;
+}
+
+// one loop: the interrupt, then the plant for a loop period
+static void SimLoop(Plant_t const *pPlant)
+{
+  double  Dt = 1.0 / (MOTOR_CONTROL_HZ * SIM_STEPS_PER_LOOP);
+  double  Drive;
+  int     Step;
+
+  // the encoder, with the estimate filtered as QuadEncoder does it
+  Filtered += (Speed - Filtered) / 4;
+  SimVelocity = (int32_t)(Filtered * 100);
+  SimPosition = (int32_t)floor(Angle * 2) * QUAD_ENCODER_CENTIDEG_PER_COUNT;
+  StepLoop();
+  for (Step = 0; Step < SIM_STEPS_PER_LOOP; Step++)
+  {
+    Drive = fabs((double)LastDuty) < pPlant->Friction ? 0 :
+        (LastDuty - copysign(pPlant->Friction, LastDuty));
+    Speed += Dt * (pPlant->K * Drive - Speed -
+        copysign(pPlant->Load, Speed)) / pPlant->Tau;
+    Angle += Dt * Speed;
+  }
+}
+
+static void SimReset(double Gain)
+{
+  Speed = 0;
+  Angle = 0;
+  Filtered = 0;
+  LastDuty = 0;
+  SimPosition = 0;
+  SimVelocity = 0;
+  MotorControl_Init(SimDrive);
+  MotorControl_SetGains(Q16(0.115 * Gain),
+      Q16(0.77 * Gain / MOTOR_CONTROL_HZ));
+}
+
+static Response_t Simulate(Plant_t const *pPlant, double Target, double Gain)
+{
+  Response_t  Result = { 0, 0, 0, 0 };
+  double      Peak = 0;
+  double      Low = 1e9;
+  double      High = -1e9;
+  double      Sum = 0;
+  double      t;
+  int         Loops = (int)(SIM_SECONDS * MOTOR_CONTROL_HZ);
+  int         Loop;
+  int         Samples = 0;
+
+  SimReset(Gain);
+  MotorControl_SetSpeed((int32_t)(Target * 100));
+  for (Loop = 0; Loop < Loops; Loop++)
+  {
+    SimLoop(pPlant);
+    t = (double)(Loop + 1) / MOTOR_CONTROL_HZ;
+    if (Speed > Peak)
+    {
+      Peak = Speed;
+    }
+    if (fabs(Speed - Target) > 0.05 * Target)
+    {
+      Result.SettleTime = t;
+    }
+    if (t > SIM_SECONDS - 1.0)
+    {
+      Sum += Speed - Target;
+      Samples++;
+      Low = (Speed < Low) ? Speed : Low;
+      High = (Speed > High) ? Speed : High;
+    }
+  }
+  Result.Overshoot = 100 * (Peak - Target) / Target;
+  Result.MeanError = Sum / Samples;
+  Result.Ripple = High - Low;
+  return Result;
+}
+
+// a move from where the last one left the motor, by Distance degrees
+static Move_t SimulateMove(Plant_t const *pPlant, double Distance)
+{
+  Move_t  Result = { -1, 0, 0, 0 };
+  double  Target = Angle + Distance;
+  double  Lag;
+  double  Past;
+  int     Loops = (int)(SIM_SECONDS * MOTOR_CONTROL_HZ);
+  int     Loop;
+
+  Arrived = false;
+  MotorControl_MoveTo((int32_t)floor(Target * 100 + 0.5), SimArrived);
+  for (Loop = 0; Loop < Loops; Loop++)
+  {
+    SimLoop(pPlant);
+    Lag = fabs((double)ProfilePos / MOTOR_CONTROL_HZ / 100 - Angle);
+    Result.MaxLag = (Lag > Result.MaxLag) ? Lag : Result.MaxLag;
+    Past = (Distance > 0) ? (Angle - Target) : (Target - Angle);
+    Result.Overshoot = (Past > Result.Overshoot) ? Past : Result.Overshoot;
+    if (Arrived && (Result.ArriveTime < 0))
+    {
+      Result.ArriveTime = (double)(Loop + 1) / MOTOR_CONTROL_HZ;
+    }
+  }
+  Result.FinalError = Angle - Target;
+  return Result;
+}
+
+int main(void)
+{
+  static Plant_t const Plants[] =
+  {
+    { "nominal", 13.0, 0.15, 15.0, 0.0 },
+    { "low battery (K -25%)", 9.75, 0.15, 15.0, 0.0 },
+    { "heavy load", 13.0, 0.25, 20.0, 60.0 },
+  };
+  static double const Moves[] = { 30, 90, 180, -360, -30, 5 };
+  Response_t  Result;
+  Move_t      Move;
+  double      Gain;
+  double      WorstLag;
+  double      WorstError;
+  unsigned    i;
+  unsigned    j;
+
+  printf("step to 300 deg/S          overshoot  settle   mean err  ripple\r\n");
+  for (i = 0; i < sizeof(Plants) / sizeof(Plants[0]); i++)
+  {
+    Result = Simulate(&Plants[i], 300.0, 1.0);
+    printf("%-26s %6.1f%%  %5.2fS  %6.2f    %6.2f deg/S\r\n", Plants[i].Name,
+        Result.Overshoot, Result.SettleTime, Result.MeanError, Result.Ripple);
+  }
+
+  // raise the gains to see how much margin the defaults have
+  printf("\r\ngain  overshoot  settle  ripple (nominal plant)\r\n");
+  for (Gain = 1.0; Gain <= 32.0; Gain *= 1.414)
+  {
+    Result = Simulate(&Plants[0], 300.0, Gain);
+    printf("%4.1fx %7.1f%%  %5.2fS  %6.2f deg/S%s\r\n", Gain,
+        Result.Overshoot, Result.SettleTime, Result.Ripple,
+        (Result.SettleTime >= SIM_SECONDS - 0.01) ? "  does not settle" : "");
+  }
+
+  // moves on the default profile, each from where the last one ended
+  for (i = 0; i < sizeof(Plants) / sizeof(Plants[0]); i++)
+  {
+    printf("\r\nmoves, %-20s arrive  overshoot  max lag  final\r\n",
+        Plants[i].Name);
+    SimReset(1.0);
+    for (j = 0; j < sizeof(Moves) / sizeof(Moves[0]); j++)
+    {
+      Move = SimulateMove(&Plants[i], Moves[j]);
+      printf("%+6.0f deg                   %5.2fS  %6.2f    %6.2f  %+6.2f deg"
+          "\r\n", Moves[j], Move.ArriveTime, Move.Overshoot, Move.MaxLag,
+          Move.FinalError);
+    }
+  }
+
+  // the same moves a thousand turns on, as after a long run in speed mode,
+  // where the profile's position no longer fits in 32 bits
+  printf("\r\nmoves, %-20s arrive  overshoot  max lag  final\r\n",
+      "1000 turns on");
+  SimReset(1.0);
+  Angle = 1000 * 360.0;
+  SimPosition = (int32_t)(Angle * 100);
+  for (j = 0; j < sizeof(Moves) / sizeof(Moves[0]); j++)
+  {
+    Move = SimulateMove(&Plants[0], Moves[j]);
+    printf("%+6.0f deg                   %5.2fS  %6.2f    %6.2f  %+6.2f deg"
+        "\r\n", Moves[j], Move.ArriveTime, Move.Overshoot, Move.MaxLag,
+        Move.FinalError);
+  }
+
+  // a sweep through the 12 LED positions, as a self test would make it
+  for (i = 0; i < sizeof(Plants) / sizeof(Plants[0]); i++)
+  {
+    SimReset(1.0);
+    WorstLag = 0;
+    WorstError = 0;
+    for (j = 0; j < 12; j++)
+    {
+      Move = SimulateMove(&Plants[i], 30);
+      WorstLag = (Move.MaxLag > WorstLag) ? Move.MaxLag : WorstLag;
+      WorstError = (fabs(Move.FinalError) > WorstError) ?
+          fabs(Move.FinalError) : WorstError;
+      if (Move.ArriveTime < 0)
+      {
+        printf("LED %u never arrived\r\n", j);
+      }
+    }
+    printf("\r\nLED sweep, %-20s worst lag %.2f, worst final %.2f deg\r\n",
+        Plants[i].Name, WorstLag, WorstError);
+  }
+  return 0;
+}
+#endif
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -147,8 +147,8 @@ ES_Event_t RunOptoSensorService(ES_Event_t ThisEvent)
     break;
     case (ES_INIT):
     {
-      //Initialize the timer
-      ES_Timer_InitTimer(OPTO_TIMER, WAIT);
+      //Initialize the timer, it re-arms itself every WAIT until stopped
+      ES_Timer_InitPeriodic(OPTO_TIMER, WAIT);
     }
     break;
 
@@ -171,15 +171,11 @@ ES_Event_t RunOptoSensorService(ES_Event_t ThisEvent)
       {
         //Switch States
         CurrentState = Idle;
+        ES_Timer_StopTimer(OPTO_TIMER);
         ES_Event_t newEvent;
         newEvent.EventType = ES_HAND_DETECTED;
         PostGameService(newEvent); //post to game service
       }
-      else
-      {
-        //Restart Timer
-        ES_Timer_InitTimer(OPTO_TIMER, WAIT);
-      }
     }
     break;
     default:
@@ -198,7 +194,7 @@ ES_Event_t RunOptoSensorService(ES_Event_t ThisEvent)
     {
       //Change State to Active and Init Timer
       CurrentState = Active;
-      ES_Timer_InitTimer(OPTO_TIMER, WAIT);
+      ES_Timer_InitPeriodic(OPTO_TIMER, WAIT);
     }
     break;
     case (RESET):
@@ -0,0 +1,476 @@
+/****************************************************************************
+ Module
+     QuadEncoder.c
+ Description
+     Decodes the quadrature encoder on the DC motor (A on RB9, B on RB8) in
+     the change notification interrupt, counting every edge of both
+     channels (4x decoding), and estimates the motor's angular velocity
+ Notes
+     Each interrupt reads both lines and looks the move from the last state
+     to the new one up in a table. A move of one step counts up or down. A
+     change of both lines at once means that an edge was missed (or the
+     lines bounced faster than the interrupt) and the direction can not be
+     known, so it is counted as an error and not counted at all.
+     Counting up is the direction that the DC motor service calls CCW, the
+     same as the old polled decoder, which counted 2 on each falling edge
+     of A. The 4x count is therefore twice the old count.
+     The count is only written by the ISR and is a single aligned 32 bit
+     word, so a read of it is one lw and can not be torn.
+     The change notification interrupt is shared by all of the pins on
+     port B, this module assumes that it has the only ones enabled.
+     Velocity: at low speed the time between rising edges of A is measured
+     by input capture 2, which also interrupts on each of them. A rising
+     edge of A is 4 counts from the last one, so that gives the speed to a
+     small fraction of a count, where counting edges for a window could
+     only give it to the nearest count. Timer2 & 3 both run the PWM, so neither
+     can be a free running time base for the capture. IC2 captures Timer3
+     anyway and the ISR uses that to take its own latency off of the core
+     timer count that it reads, giving the time of the edge to 0.4uS.
+     At high speed counting edges over the window is accurate enough and
+     the capture interrupt is turned off, to save its load.
+     QuadEncoder_UpdateVelocity makes the estimate and must be called once
+     per window, MotorControl.c calls it from its control loop ISR.
+     Timer3 must be set up (by the PWM library) before QuadEncoder_Init.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 08:00 mss     the counts per revolution moved to QuadEncoder.h
+ 10/17/26 07:00 mss     the switch between timing edges and counting them is
+                        now at a speed, not counts per window, since the
+                        window is now the 10mS of the motor control loop.
+                        SetCount keeps an offset, so that it need not hold
+                        off the control loop's velocity update
+ 10/17/26 06:00 mss     added the velocity estimate, from input capture at
+                        low speed and the count over a window at high speed
+ 10/17/26 05:00 mss     started coding, replaces the polled decoding in
+                        DCMotorService.c
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <xc.h>
+#include <sys/attribs.h>
+#include "ES_Port.h"
+#include "PIC32_PORT_HAL.h"
+#include "QuadEncoder.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// Encoder Ports
+#define ENC_PORT _Port_B
+#define ENCA_PIN _Pin_9
+#define ENCB_PIN _Pin_8
+#define ENCA_BIT 9
+#define ENCB_BIT 8
+
+// IC2 input select for RB9
+#define IC2_FROM_RB9 0b0100
+// capture on every rising edge
+#define ICM_EVERY_RISING 0b011
+
+// interrupt priority, must match the IPL in the __ISR()s below. Above the
+// core timer tick (3) so that a long tick catch-up can not cost us an edge,
+// below the short timers (6)
+#define ENCODER_PRIORITY 5
+
+// the table entry for a change of both lines
+#define ILLEGAL 2
+
+// velocity is in 1/100 degree per second
+#define CENTIDEG_PER_COUNT QUAD_ENCODER_CENTIDEG_PER_COUNT
+#define CENTIDEG_PER_CYCLE (CENTIDEG_PER_COUNT * QUAD_ENCODER_COUNTS_PER_CYCLE)
+// the core timer rate
+#define CORE_COUNTS_PER_SEC (ES_CORE_COUNTS_PER_US * 1000000UL)
+// core timer counts per Timer3 count, Timer3 runs at PBCLK (20MHz) / 8
+#define CORE_COUNTS_PER_T3 8
+
+// switch to counting over the window at this speed, and back to timing
+// edges below PERIOD_MODE_SPEED, in 1/100 degree per second
+#define WINDOW_MODE_SPEED 80000
+#define PERIOD_MODE_SPEED 60000
+// with no rising edge of A for this long the motor is taken to have
+// stopped, 200mS is 10 degrees per second
+#define STOPPED_COUNTS (CORE_COUNTS_PER_SEC / 5)
+// the velocity is filtered by moving it 1/2^VEL_FILTER_SHIFT of the way
+// to each new estimate
+#define VEL_FILTER_SHIFT 2
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t ReadState(uint32_t PortBits);
+static void StartCaptures(void);
+static int32_t EstimateFromPeriod(uint32_t Now);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the step for each move, indexed by (last state << 2) | new state, where
+// a state is (A << 1) | B. Counting up, the states go 00 01 11 10 00
+static int8_t const StepTable[16] =
+{
+  //  to 00    to 01    to 10    to 11
+         0,      +1,      -1, ILLEGAL,   // from 00
+        -1,       0, ILLEGAL,      +1,   // from 01
+        +1, ILLEGAL,       0,      -1,   // from 10
+   ILLEGAL,      -1,      +1,       0    // from 11
+};
+
+static volatile int32_t   Count;
+static int32_t            CountOffset;  // added to Count by GetCount
+static volatile uint32_t  ErrorCount;
+static uint8_t            LastState;
+
+// written by the capture ISR
+static volatile uint32_t  LastEdgeTime;   // core count at the last rising A
+static volatile uint32_t  LastPeriod;     // between the last 2, 0 if unknown
+static volatile bool      HaveEdge;       // LastEdgeTime is good
+static volatile int8_t    EdgeSign;       // +1 counting up, -1 down
+
+// used by QuadEncoder_UpdateVelocity
+static int32_t  LastPosition;
+static uint32_t LastUpdateTime;
+static bool     IsWindowMode;
+static volatile int32_t Velocity;   // the filtered estimate
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   QuadEncoder_Init
+ Parameters
+   None
+ Returns
+   bool, false if the pins could not be set up
+ Description
+   sets up RB9 & RB8 as digital inputs with change notification and
+   enables the change notification interrupt, with the count at 0, then
+   input capture 2 on RB9 for the velocity
+ Notes
+   Timer3 must already be running, see the notes above
+ Author
+   M. Saboo, 10/17/26, 05:00
+****************************************************************************/
+bool QuadEncoder_Init(void)
+{
+  if (!PortSetup_ConfigureDigitalInputs(ENC_PORT, ENCA_PIN | ENCB_PIN))
+  {
+    return false;
+  }
+  if (!PortSetup_ConfigureChangeNotification(ENC_PORT, ENCA_PIN | ENCB_PIN))
+  {
+    return false;
+  }
+  IEC1CLR     = _IEC1_CNBIE_MASK;
+  Count       = 0;
+  CountOffset = 0;
+  ErrorCount  = 0;
+  // reading the port also ends any mismatch left from before
+  LastState   = ReadState(PORTB);
+  IFS1CLR     = _IFS1_CNBIF_MASK;
+  IPC8bits.CNIP = ENCODER_PRIORITY;
+  IEC1SET     = _IEC1_CNBIE_MASK;
+
+  // input capture 2 on A, capturing Timer3 on every rising edge
+  IC2CON              = 0;
+  IC2R                = IC2_FROM_RB9;
+  IC2CONbits.ICTMR    = 0;  // Timer3
+  IC2CONbits.ICI      = 0;  // interrupt on every capture
+  IC2CONbits.ICM      = ICM_EVERY_RISING;
+  IPC2bits.IC2IP      = ENCODER_PRIORITY;
+  IC2CONbits.ON       = 1;
+  LastPosition        = 0;
+  LastUpdateTime      = _CP0_GET_COUNT();
+  IsWindowMode        = false;
+  Velocity            = 0;
+  StartCaptures();
+  return true;
+}
+
+/****************************************************************************
+ Function
+   QuadEncoder_GetCount
+ Parameters
+   None
+ Returns
+   int32_t, the edges counted since the count was last set, up when the
+   motor turns CCW
+ Author
+   M. Saboo, 10/17/26, 05:00
+****************************************************************************/
+int32_t QuadEncoder_GetCount(void)
+{
+  return Count + CountOffset; // one lw of Count, the ISR can't change half
+}
+
+/****************************************************************************
+ Function
+   QuadEncoder_SetCount
+ Parameters
+   int32_t NewCount, the new value for the count
+ Returns
+   nothing
+ Description
+   sets the count, for example to re-zero the position
+ Notes
+   Only the offset added by QuadEncoder_GetCount changes, the ISR's count
+   and so the velocity window go on undisturbed. Call from the same level
+   as QuadEncoder_GetCount (the services), the offset is not atomic with
+   respect to it.
+ Author
+   M. Saboo, 10/17/26, 05:00
+****************************************************************************/
+void QuadEncoder_SetCount(int32_t NewCount)
+{
+  CountOffset = NewCount - Count;
+}
+
+/****************************************************************************
+ Function
+   QuadEncoder_GetErrorCount
+ Parameters
+   None
+ Returns
+   uint32_t, the number of illegal transitions (both lines changing at
+   once) since QuadEncoder_Init
+ Description
+   each error is at least 2 edges that were missed, so any errors mean that
+   the count can no longer be trusted to the last few counts
+ Author
+   M. Saboo, 10/17/26, 05:00
+****************************************************************************/
+uint32_t QuadEncoder_GetErrorCount(void)
+{
+  return ErrorCount;
+}
+
+/****************************************************************************
+ Function
+   QuadEncoder_UpdateVelocity
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   makes a new estimate of the velocity and adds it to the filtered one
+ Notes
+   Call once per window, at a steady rate. The window is timed with the
+   core timer, so the rate does not have to be exact. Changes between
+   timing edges and counting over the window as the speed crosses
+   WINDOW_MODE_SPEED & PERIOD_MODE_SPEED.
+ Author
+   M. Saboo, 10/17/26, 06:00
+****************************************************************************/
+void QuadEncoder_UpdateVelocity(void)
+{
+  uint32_t  Now       = _CP0_GET_COUNT();
+  int32_t   Position  = Count;
+  int32_t   Delta     = Position - LastPosition;
+  uint32_t  Window    = Now - LastUpdateTime;
+  int32_t   Estimate;
+
+  LastPosition    = Position;
+  LastUpdateTime  = Now;
+  if (IsWindowMode)
+  {
+    Estimate = (int32_t)(((int64_t)Delta * CENTIDEG_PER_COUNT *
+        CORE_COUNTS_PER_SEC) / Window);
+    if ((Estimate < PERIOD_MODE_SPEED) && (Estimate > -PERIOD_MODE_SPEED))
+    {
+      IsWindowMode = false;
+      StartCaptures();
+    }
+  }
+  else
+  {
+    Estimate = EstimateFromPeriod(Now);
+    if ((Estimate >= WINDOW_MODE_SPEED) || (Estimate <= -WINDOW_MODE_SPEED))
+    {
+      IsWindowMode = true;
+      IEC0CLR = _IEC0_IC2IE_MASK;  // the captures are not needed now
+    }
+  }
+  Velocity += (Estimate - Velocity) / (1 << VEL_FILTER_SHIFT);
+}
+
+/****************************************************************************
+ Function
+   QuadEncoder_GetVelocity
+ Parameters
+   None
+ Returns
+   int32_t, the filtered angular velocity in 1/100 degree per second,
+   positive when the count is going up (CCW)
+ Notes
+   updated by QuadEncoder_UpdateVelocity, once per window
+ Author
+   M. Saboo, 10/17/26, 06:00
+****************************************************************************/
+int32_t QuadEncoder_GetVelocity(void)
+{
+  return Velocity;
+}
+
+/****************************************************************************
+ Function
+   QuadEncoderISR
+ Description
+   the change notification interrupt response, counts the move from the
+   last state to the new one
+ Notes
+   PORTB is read before the flag is cleared, since the read is what ends
+   the mismatch that raised the flag. An edge after the read raises it
+   again.
+ Author
+   M. Saboo, 10/17/26, 05:00
+****************************************************************************/
+void __ISR(_CHANGE_NOTICE_VECTOR, IPL5AUTO) QuadEncoderISR(void)
+{
+  uint8_t NewState = ReadState(PORTB);
+  int8_t  Step;
+
+  IFS1CLR   = _IFS1_CNBIF_MASK;
+  Step      = StepTable[(LastState << 2) | NewState];
+  LastState = NewState;
+  if (Step == ILLEGAL)
+  {
+    ErrorCount++;
+  }
+  else
+  {
+    Count += Step;
+  }
+}
+
+/****************************************************************************
+ Function
+   VelocityCaptureISR
+ Description
+   the input capture 2 interrupt response, times each rising edge of A and
+   the period since the one before
+ Notes
+   The capture is the Timer3 count at the edge, and Timer3 has counted on
+   since, so the difference is how long ago the edge was. Timer3 wraps at
+   PR3, 2mS at the 500Hz PWM, far longer than this ISR can be held off.
+   The direction comes from B, which is high at a rising edge of A when
+   counting up.
+ Author
+   M. Saboo, 10/17/26, 06:00
+****************************************************************************/
+void __ISR(_INPUT_CAPTURE_2_VECTOR, IPL5AUTO) VelocityCaptureISR(void)
+{
+  uint32_t  Now   = _CP0_GET_COUNT();
+  uint16_t  Timer = TMR3;
+  uint16_t  Capture;
+  uint32_t  Ago;
+  uint32_t  EdgeTime;
+
+  // there may be more than one edge waiting, take them in order
+  while (IC2CONbits.ICBNE)
+  {
+    Capture = (uint16_t)IC2BUF;
+    Ago     = (Timer >= Capture) ? (uint32_t)(Timer - Capture) :
+        ((uint32_t)Timer + PR3 + 1 - Capture);
+    EdgeTime = Now - (Ago * CORE_COUNTS_PER_T3);
+    if (HaveEdge)
+    {
+      LastPeriod = EdgeTime - LastEdgeTime;
+    }
+    LastEdgeTime  = EdgeTime;
+    HaveEdge      = true;
+  }
+  EdgeSign = (ReadState(PORTB) & 1) ? 1 : -1;
+  IFS0CLR = _IFS0_IC2IF_MASK;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   ReadState
+ Parameters
+   uint32_t PortBits, a read of PORTB
+ Returns
+   uint8_t, (A << 1) | B
+ Author
+   M. Saboo, 10/17/26, 05:00
+****************************************************************************/
+static uint8_t ReadState(uint32_t PortBits)
+{
+  return (uint8_t)((((PortBits >> ENCA_BIT) & 1) << 1) |
+                   ((PortBits >> ENCB_BIT) & 1));
+}
+/****************************************************************************
+ Function
+   StartCaptures
+ Parameters
+   None
+ Returns
+   nothing
+ Description
+   throws away any old captures and enables the capture interrupt, with no
+   edge timed yet
+ Author
+   M. Saboo, 10/17/26, 06:00
+****************************************************************************/
+static void StartCaptures(void)
+{
+  IEC0CLR = _IEC0_IC2IE_MASK;
+  while (IC2CONbits.ICBNE)
+  {
+    (void)IC2BUF;
+  }
+  HaveEdge    = false;
+  LastPeriod  = 0;
+  IFS0CLR     = _IFS0_IC2IF_MASK;
+  IEC0SET     = _IEC0_IC2IE_MASK;
+}
+
+/****************************************************************************
+ Function
+   EstimateFromPeriod
+ Parameters
+   uint32_t Now, the core timer count
+ Returns
+   int32_t, the velocity from the last period of A, in 1/100 degree/S
+ Description
+   While the motor slows the next edge is late, so once the time since the
+   last edge is longer than the last period it is used instead, and the
+   estimate falls toward 0 rather than holding the last speed. After
+   STOPPED_COUNTS with no edge the estimate is 0.
+ Author
+   M. Saboo, 10/17/26, 06:00
+****************************************************************************/
+static int32_t EstimateFromPeriod(uint32_t Now)
+{
+  uint32_t  Period;
+  uint32_t  SinceEdge;
+  int8_t    Sign;
+  bool      HavePeriod;
+
+  IEC0CLR     = _IEC0_IC2IE_MASK;  // a consistent set from the ISR
+  Period      = LastPeriod;
+  SinceEdge   = Now - LastEdgeTime;
+  Sign        = EdgeSign;
+  HavePeriod  = HaveEdge && (Period != 0);
+  if (HaveEdge && (SinceEdge >= STOPPED_COUNTS))
+  {
+    HaveEdge    = false;  // start over from the next edge
+    LastPeriod  = 0;
+  }
+  IEC0SET     = _IEC0_IC2IE_MASK;
+  // an edge timed to within a Timer3 count of Now can come out just after
+  // it
+  if ((int32_t)SinceEdge < 0)
+  {
+    SinceEdge = 0;
+  }
+
+  if (!HavePeriod || (SinceEdge >= STOPPED_COUNTS))
+  {
+    return 0;
+  }
+  if (SinceEdge > Period)
+  {
+    Period = SinceEdge;
+  }
+  // CENTIDEG_PER_CYCLE * CORE_COUNTS_PER_SEC is 4e9, just inside 32 bits
+  return Sign * (int32_t)(((uint32_t)CENTIDEG_PER_CYCLE * CORE_COUNTS_PER_SEC)
+      / Period);
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -41,9 +41,10 @@
 // TICS_PER_MS assumes a 20MHz PBClk /8 = 2.5MHz clock rate
 #define TICS_PER_MS 2500
 
-// these are the initial extents of servo motion
-#define FULL_CW ((uint16_t)(0.7 * TICS_PER_MS))
-#define FULL_CCW ((uint16_t)(2.25 * TICS_PER_MS))
+// these are the initial extents of servo motion, 0.7mS and 2.25mS, in
+// integer math
+#define FULL_CW ((uint16_t)(7 * TICS_PER_MS / 10))
+#define FULL_CCW ((uint16_t)(9 * TICS_PER_MS / 4))
 #define MID_POINT (cwLimit + ((ccwLimit - cwLimit) / 2))
 
 // these are related to how fast we move. full range of motion in 100 steps
@@ -137,8 +137,8 @@ ES_Event_t RunThrottleService(ES_Event_t ThisEvent)
   {
   case (ES_INIT):
   {
-    //Set Timer
-    ES_Timer_InitTimer(THROTTLE_TIMER, POST_THROTTLE_TIME);
+    //Set Timer, it re-arms itself every POST_THROTTLE_TIME
+    ES_Timer_InitPeriodic(THROTTLE_TIMER, POST_THROTTLE_TIME);
   }
   break;
 
@@ -152,8 +152,6 @@ ES_Event_t RunThrottleService(ES_Event_t ThisEvent)
     Event2Post.EventType = THROTTLE_VALUE;
     Event2Post.EventParam = (uint16_t)currentVal[1];
     PostGameService(Event2Post);
-    //Re-Init Timer
-    ES_Timer_InitTimer(THROTTLE_TIMER, POST_THROTTLE_TIME);
   }
   break;
 
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""
+ Module
+     es_trace_decode.py
+ Description
+     Turns the terminal output of a build with ES_TRACE defined into a
+     readable timeline of framework activity.
+ Notes
+     Reads the raw bytes from the UART (a file, or stdin when no file is
+     given), for example:
+         python3 Tools/es_trace_decode.py capture.bin
+         cat /dev/ttyUSB0 | python3 Tools/es_trace_decode.py
+     The event, service and timer names come from ES_Configure.h, so it
+     must be the one the code was built with (see --config).
+     The frame format is described at the top of FrameworkSource/ES_Trace.c.
+     Any bytes that are not part of a good frame are printf output and are
+     printed as text between the trace lines.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 10:00 mss      hold the timeline on a frame stamped out of order
+ 10/16/26 18:00 mss      added PUBLISH records
+ 10/16/26 17:00 mss      started coding
+"""
+import argparse
+import os
+import re
+import sys
+
+FRAME_LEN = 11
+TRACE_SYNC = 0xA5
+COUNTS_PER_US = 20      # the core timer runs at 20MHz
+
+# must match ES_TraceKind_t in ES_Trace.h
+KIND_NAMES = {
+    1: "POST",
+    2: "POST_LIFO",
+    3: "POST_ISR",
+    4: "POST_ALL",
+    5: "DEQUEUE",
+    6: "RUN_START",
+    7: "RUN_END",
+    8: "TIMEOUT",
+    9: "OVERFLOW",
+    10: "PUBLISH",
+}
+KIND_POST_ALL = 4
+KIND_PUBLISH = 10
+KIND_TIMEOUT = 8
+KIND_OVERFLOW = 9
+
+
+def strip_comments(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    return re.sub(r"//[^\n]*", "", text)
+
+
+def read_config(path):
+    """returns the event, service and timer names from ES_Configure.h"""
+    with open(path) as config_file:
+        text = strip_comments(config_file.read())
+
+    events = {}
+    match = re.search(r"typedef\s+enum\s*\{(.*?)\}\s*ES_EventType_t\s*;",
+                      text, re.S)
+    if match:
+        value = 0
+        for entry in match.group(1).split(","):
+            entry = entry.strip()
+            if not entry:
+                continue
+            name, _, explicit = entry.partition("=")
+            if explicit.strip():
+                value = int(explicit.strip(), 0)
+            events[value] = name.strip()
+            value += 1
+
+    services = {int(n): name for n, name in
+                re.findall(r"#define\s+SERV_(\d+)_RUN\s+Run(\w+)", text)}
+    timers = {int(n): name for name, n in
+              re.findall(r"#define\s+(\w+_TIMER)\s+(\d+)\b", text)}
+    return events, services, timers
+
+
+def find_frames(data):
+    """yields ("text", bytes) and ("frame", bytes) pieces of the capture"""
+    text_start = 0
+    i = 0
+    while i <= len(data) - FRAME_LEN:
+        if data[i] == TRACE_SYNC:
+            frame = data[i:i + FRAME_LEN]
+            if (sum(frame[1:10]) + frame[10]) & 0xFF == 0xFF:
+                if i > text_start:
+                    yield "text", data[text_start:i]
+                yield "frame", frame
+                i += FRAME_LEN
+                text_start = i
+                continue
+        i += 1
+    if text_start < len(data):
+        yield "text", data[text_start:]
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(
+        description="decode the ES_TRACE frames in a terminal capture")
+    parser.add_argument("capture", nargs="?",
+                        help="raw terminal output, stdin if not given")
+    parser.add_argument("--config", default=os.path.join(
+        here, "..", "FrameworkHeaders", "ES_Configure.h"),
+        help="the ES_Configure.h the code was built with")
+    parser.add_argument("--no-text", action="store_true",
+                        help="leave out the printf output")
+    args = parser.parse_args()
+
+    events, services, timers = read_config(args.config)
+    if args.capture:
+        with open(args.capture, "rb") as capture_file:
+            data = capture_file.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    first_time = None
+    last_time = 0
+    elapsed = 0
+    for piece, raw in find_frames(data):
+        if piece == "text":
+            if not args.no_text:
+                text = raw.decode("ascii", "replace").replace("\r", "")
+                for line in text.splitlines():
+                    if line.strip():
+                        print("%14s  | %s" % ("", line))
+            continue
+
+        kind, which, event_type = raw[1], raw[2], raw[3]
+        param = raw[4] | (raw[5] << 8)
+        time = raw[6] | (raw[7] << 8) | (raw[8] << 16) | (raw[9] << 24)
+        # the core timer wraps every 214 seconds, keep a running total
+        if first_time is None:
+            first_time = last_time = time
+        delta = (time - last_time) & 0xFFFFFFFF
+        # a frame stamped before the one ahead of it would look like almost
+        # a whole wrap, hold the timeline instead of jumping 214 seconds
+        if delta < 0x80000000:
+            elapsed += delta
+            last_time = time
+
+        if kind == KIND_OVERFLOW:
+            print("%12.1fus  *** %u records lost, trace buffer was full" %
+                  (elapsed / COUNTS_PER_US, param))
+            continue
+        if kind == KIND_POST_ALL:
+            target = "all"
+        elif kind == KIND_PUBLISH:
+            target = "subscribers"
+        elif kind == KIND_TIMEOUT:
+            target = "timer %u %s" % (which, timers.get(which, ""))
+        else:
+            target = "%u %s" % (which, services.get(which, ""))
+        print("%12.1fus  %-9s %-28s %s(%u)" % (
+            elapsed / COUNTS_PER_US, KIND_NAMES.get(kind, "kind %u" % kind),
+            target.strip(), events.get(event_type, "event %u" % event_type),
+            param))
+
+
+if __name__ == "__main__":
+    main()